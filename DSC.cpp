@@ -2,7 +2,13 @@
 #include "DSC.h"
 #include "DSC_Constants.h"
 #include "DSC_Globals.h"
-#include <TextBuffer.h>
+#if defined(__AVR__)
+#include <avr/sleep.h>
+#endif
+#if defined(ESP32)
+#include <freertos/FreeRTOS.h>
+#include <freertos/task.h>
+#endif
 
 /// ----- GLOBAL VARIABLES -----
 /*
@@ -13,37 +19,259 @@
  * The following structures contains all of the global variables used by the ISR to 
  * communicate with the DSC.clkCalled() object. You cannot pass parameters to an 
  * ISR so these values must be global. The fields are defined in DSC_Globals.h
+ * There is one block for each keybus, used by the DSC instance with that busNum (a
+ * decoder only instance is given its own, see DSC(dscBus_t &state)).
  */
-timing_t  timing;
-keybus_t  panel;
-keybus_t  keypad;
-keysend_t keysend;
+dscBus_t dscBus[MAX_BUSES];
 
-// ----- Input/Output Pins (Global, defined in DSC_Globals.h) -----
-byte CLK;         // Keybus Yellow (Clock Line)
-byte DTA_IN;      // Keybus Green (Data Line via V divider)
-byte DTA_OUT;     // Keybus Green Output (Data Line through driver)
-byte LED;         // LED pin on the arduino
+// The keybuses taken by an instance (bit n = keybus n), and the block given to an 
+// instance which was refused one, it is never attached to an interrupt
+static byte busUsed = 0;
+static dscBus_t noBus;
 
-// Prototype for interrupt handler, called on clock line change
-void clkCalled_Handler(); 
+// Takes keybus "n" for a new instance, returns DSC_NO_BUS if it is out of range or
+// already taken
+static byte takeBus(byte n)
+  {
+    if (n >= MAX_BUSES || (busUsed & (1 << n))) return DSC_NO_BUS;
+    busUsed |= 1 << n;
+    return n;
+  }
+
+// Prototype for interrupt handler of keybus N, called on clock line change
+template <byte N> void clkCalled_Handler(); 
+
+// Prototype for the clock edge handler used by the ISR and DSC.injectEdge()
+static inline bool clkEdge(dscBus_t &bus, bool clk, bool data, unsigned long now)
+    __attribute__((always_inline));
+
+// Prototype for raisePriority, the priority lane flags raised from within clkEdge()
+static inline void raisePriority(dscBus_t &bus, byte flag, bool on, bool held, 
+                                 unsigned long now) __attribute__((always_inline));
 
 // Prototype for wordCpy, to copy an array to another array of equal length (len)
-void wordCpy(byte *a, byte *b, byte len);
+// The word arrays are shared with the ISR, so these take volatile arrays (plain 
+// arrays are converted to them)
+void DSC_IRAM wordCpy(const volatile byte *a, volatile byte *b, byte len);
 
 // Prototype for wordSet, to reset each element of an array of length (len) to int b
-void wordSet(byte *a, int b, byte len);
+void DSC_IRAM wordSet(volatile byte *a, int b, byte len);
+
+// Prototype for wordChkSum, the checksum of a panel word array of length (len) bits
+int wordChkSum(const volatile byte *a, int len);
+
+// Prototype for wordChkOk, true if the checksum of a panel word array is valid
+bool wordChkOk(const volatile byte *a, int len);
+
+// Prototype for wordEq, true if two arrays of equal length (len) are the same
+bool wordEq(const byte *a, const volatile byte *b, byte len);
+
+
+/* The keypad key table, every key once, in KEY_xxx order: the 1st byte of its word
+ * (kOut, or the key itself for Fire/Aux/Panic), the 2nd byte, and its name.  The
+ * decode lookup below and send_key(key) are both built from it, and it is checked
+ * when compiling that no two keys share the same bytes.
+ */
+typedef struct
+{
+  byte key;                       // KEY_xxx, must match the position in the table
+  byte first;                     // 1st byte of the word
+  byte code;                      // 2nd byte of the word
+  char name[6];
+}
+kpdKey_t;
+
+constexpr kpdKey_t kpdKeys[KEY_COUNT] PROGMEM = {
+  { KEY_NONE,  0,    0,      ""      },
+  { KEY_0,     kOut, zero,   "0"     },
+  { KEY_1,     kOut, one,    "1"     },
+  { KEY_2,     kOut, two,    "2"     },
+  { KEY_3,     kOut, three,  "3"     },
+  { KEY_4,     kOut, four,   "4"     },
+  { KEY_5,     kOut, five,   "5"     },
+  { KEY_6,     kOut, six,    "6"     },
+  { KEY_7,     kOut, seven,  "7"     },
+  { KEY_8,     kOut, eight,  "8"     },
+  { KEY_9,     kOut, nine,   "9"     },
+  { KEY_STAR,  kOut, aster,  "*"     },
+  { KEY_POUND, kOut, pound,  "#"     },
+  { KEY_STAY,  kOut, stay,   "Stay"  },
+  { KEY_AWAY,  kOut, away,   "Away"  },
+  { KEY_CHIME, kOut, chime,  "Chime" },
+  { KEY_RESET, kOut, reset,  "Reset" },
+  { KEY_EXIT,  kOut, kExit,  "Exit"  },
+  { KEY_LEFT,  kOut, lArrow, "<"     },   // The arrows don't work every time, they
+  { KEY_RIGHT, kOut, rArrow, ">"     },   // are often reversed for unknown reasons
+  { KEY_FIRE,  fire, k_ff,   "Fire"  },   // Sent twice, with a panel word in between
+  { KEY_AUX,   aux,  k_ff,   "Aux"   },
+  { KEY_PANIC, panic, k_ff,  "Panic" } };
+
+// The first key at or after "i" sent as bytes "first", "code" (KEY_NONE if none)
+constexpr byte kpdFind(byte first, byte code, byte i)
+  {
+    return (i >= KEY_COUNT) ? KEY_NONE :
+           (kpdKeys[i].first == first && kpdKeys[i].code == code) ? i : 
+           kpdFind(first, code, i + 1);
+  }
+
+// Each key is at its own position and is the only key with its bytes
+constexpr bool kpdKeysOk(byte i)
+  {
+    return (i >= KEY_COUNT) || (kpdKeys[i].key == i && 
+           kpdFind(kpdKeys[i].first, kpdKeys[i].code, 1) == i && kpdKeysOk(i + 1));
+  }
+static_assert(kpdKeysOk(1), "Keypad key table is out of order or has a duplicate");
+
+// The key sent after kOut for each 2nd byte value, so decoding is one lookup
+#define KPD_KEY(c)  kpdFind(kOut, (c), 1)
+#define KPD_ROW(r)  KPD_KEY(r+0x0), KPD_KEY(r+0x1), KPD_KEY(r+0x2), KPD_KEY(r+0x3), \
+                    KPD_KEY(r+0x4), KPD_KEY(r+0x5), KPD_KEY(r+0x6), KPD_KEY(r+0x7), \
+                    KPD_KEY(r+0x8), KPD_KEY(r+0x9), KPD_KEY(r+0xa), KPD_KEY(r+0xb), \
+                    KPD_KEY(r+0xc), KPD_KEY(r+0xd), KPD_KEY(r+0xe), KPD_KEY(r+0xf)
+const byte kpdCodeKey[256] PROGMEM = {
+  KPD_ROW(0x00), KPD_ROW(0x10), KPD_ROW(0x20), KPD_ROW(0x30),
+  KPD_ROW(0x40), KPD_ROW(0x50), KPD_ROW(0x60), KPD_ROW(0x70),
+  KPD_ROW(0x80), KPD_ROW(0x90), KPD_ROW(0xa0), KPD_ROW(0xb0),
+  KPD_ROW(0xc0), KPD_ROW(0xd0), KPD_ROW(0xe0), KPD_ROW(0xf0) };
+#undef KPD_ROW
+#undef KPD_KEY
+
+/* The panel word field schema, every field the decode stage extracts, by command:
+ * its first bit (counted as byteToInt() does, the padding bit is bit 8), width, 
+ * where the value goes (FLD_xxx, "arg" is the light bit, the digit weight or the
+ * user code offset), which partitions it is decoded for (PART_xxx), the STATE_xxx
+ * bits its values 0-3 set, and the text printed by the formatter for its values
+ * split by '|' ("|, Fire" is nothing for 0, and ", Fire" for 1).  The decode, the
+ * state kept by the class and the format stages all run over it, so a field is
+ * moved with a change to its line.  The commands must be in order, which is 
+ * checked when compiling with the widths and the word length.
+ */
+typedef struct
+{
+  byte cmd;                       // Command byte of the word
+  byte offset;                    // First bit
+  byte width;                     // Bits (1 to 8)
+  byte dest;                      // FLD_xxx
+  byte arg;                       // LIGHT_xxx for FLD_LIGHT, weight for FLD_YEAR
+  byte part;                      // PART_xxx
+  byte state[4];                  // STATE_xxx bits set by the values 0-3
+  char names[26];                 // Formatter text of the values
+}
+pnlField_t;
+
+constexpr pnlField_t pnlFields[] PROGMEM = {
+  // ----- 0x05 Status, in message order -----
+  { 0x05, 16, 1, FLD_LIGHT,      LIGHT_READY,   PART_EACH,   { 0, STATE_READY }, ""                          },
+  { 0x05, 15, 1, FLD_LIGHT,      LIGHT_ARMED,   PART_EACH,   { 0, STATE_ARMED }, ""                          },
+  { 0x05, 10, 1, FLD_LIGHT,      LIGHT_FIRE,    PART_EACH,   {},                 "|, Fire"                   },
+  { 0x05, 12, 1, FLD_LIGHT,      LIGHT_TROUBLE, PART_EACH,   {},                 "|, Error"                  },
+  { 0x05, 13, 1, FLD_LIGHT,      LIGHT_BYPASS,  PART_EACH,   {},                 "|, Bypass"                 },
+  { 0x05, 14, 1, FLD_LIGHT,      LIGHT_MEMORY,  PART_EACH,   {},                 "|, Memory"                 },
+  { 0x05, 17, 1, FLD_LIGHT,      LIGHT_PROGRAM, PART_EACH,   {},                 "|, Program"                },
+  { 0x05, 29, 1, FLD_POWER_FAIL, 0,             PART_SINGLE, {},                 "|, Power Fail"             },   // ??? - maybe 28 or 20? (29 is partition 2's Bypass light)
+  { 0x05, 21, 2, FLD_EXIT_ALARM, 0,             PART_EACH,   { 0, 0, STATE_EXIT_DELAY, STATE_ALARM },
+                                                                                 "||, Exit Delay|, Alarm"    },   // In question
+
+  // ----- Zones, one bit per zone -----
+  { 0x27, 8+1+8+8+8+8, 8, FLD_ZONES, 0,         PART_ONCE,   {},                 ""                          },
+  { 0x2d, 8+1+8+8+8+8, 8, FLD_ZONES, 0,         PART_ONCE,   {},                 ""                          },
+  { 0x34, 8+1+8+8+8+8, 8, FLD_ZONES, 0,         PART_ONCE,   {},                 ""                          },
+  { 0x3e, 8+1+8+8+8+8, 8, FLD_ZONES, 0,         PART_ONCE,   {},                 ""                          },
+
+  // ----- 0xa5 Info, in message order (arm before the user code, see setField()) -----
+  { 0xa5,  9, 4, FLD_YEAR,       10,            PART_ONCE,   {},                 ""                          },
+  { 0xa5, 13, 4, FLD_YEAR,       1,             PART_ONCE,   {},                 ""                          },
+  { 0xa5, 19, 4, FLD_MONTH,      0,             PART_ONCE,   {},                 ""                          },
+  { 0xa5, 23, 5, FLD_DAY,        0,             PART_ONCE,   {},                 ""                          },
+  { 0xa5, 28, 5, FLD_HOUR,       0,             PART_ONCE,   {},                 ""                          },
+  { 0xa5, 33, 6, FLD_MINUTE,     0,             PART_ONCE,   {},                 ""                          },
+  { 0xa5, 17, 2, FLD_PARTITION,  0,             PART_ONCE,   {},                 ""                          },
+  { 0xa5, 41, 2, FLD_ARM,        0,             PART_ONCE,   {},                 "||Armed|Disarmed"          },
+  { 0xa5, 43, 1, FLD_MASTER,     0,             PART_ONCE,   {},                 ", User Code|, Master Code" },
+  { 0xa5, 43, 6, FLD_USER,       0x19,          PART_ONCE,   {},                 ""                          } };   // 0-36
+
+const byte PNL_FIELDS = sizeof(pnlFields) / sizeof(pnlFields[0]);
+const byte PNL_BITS = 9 + (PNL_ARR_SIZE - 2) * 8;   // Bits in the panel word buffer
+
+// The number of names in "s", less one
+constexpr byte pnlNames(const char* s)
+  {
+    return *s ? (*s == '|') + pnlNames(s + 1) : 0;
+  }
+
+// Each field fits in the word for every partition, has a name and state bits for
+// at most each of its values, and follows the commands before it
+constexpr bool pnlFieldsOk(byte i)
+  {
+    return (i >= PNL_FIELDS) || (pnlFields[i].width >= 1 && pnlFields[i].width <= 8 &&
+           pnlFields[i].offset + pnlFields[i].width + 
+             (pnlFields[i].part == PART_EACH ? (MAX_PARTITIONS - 1) * PART_BITS : 0) <= PNL_BITS &&
+           pnlFields[i].part <= PART_SINGLE &&
+           pnlNames(pnlFields[i].names) < (1 << pnlFields[i].width) &&
+           (pnlFields[i].width > 1 || (!pnlFields[i].state[2] && !pnlFields[i].state[3])) &&
+           (pnlFields[i].part == PART_EACH || !(pnlFields[i].state[0] | pnlFields[i].state[1] |
+                                                 pnlFields[i].state[2] | pnlFields[i].state[3])) &&
+           (i == 0 || pnlFields[i - 1].cmd <= pnlFields[i].cmd) && pnlFieldsOk(i + 1));
+  }
+static_assert(pnlFieldsOk(0), "Panel field schema is out of order or a field doesn't fit");
+
+// The first field of "cmd" in the schema, PNL_FIELDS if it has none
+static byte pnlFirst(byte cmd)
+  {
+    byte i = 0;
+    while (i < PNL_FIELDS && pgm_read_byte(&pnlFields[i].cmd) != cmd) i++;
+    return i;
+  }
 
-//TextBuffer tempByte(12);        // Initialize TextBuffer.h for temp generic byte buffer 
-TextBuffer wordBuf(WORD_BITS);    // Initialize TextBuffer.h for word text buffer
-TextBuffer pMsg(MSG_BITS);        // Initialize TextBuffer.h for panel message
-TextBuffer kMsg(MSG_BITS);        // Initialize TextBuffer.h for keypad message
-TextBuffer sendBuf(52);           // Initialize TextBuffer.h for sent keypad word
+// Whether a field is decoded for partition "p" (0 based) when "count" are set
+static inline bool pnlPartOn(byte part, byte p, byte count)
+  {
+    return p > 0 ? part == PART_EACH : (part != PART_SINGLE || count == 1);
+  }
 
 /// --- END GLOBAL VARIABLES ---
 
 DSC::DSC(void)
+  : busNum(takeBus(0)), bus(busNum != DSC_NO_BUS ? dscBus[0] : noBus), 
+    timing(bus.timing), panel(bus.panel), keypad(bus.keypad), 
+    keysend(bus.keysend), capture(bus.capture), priority(bus.priority)
   {
+    init();
+  }
+
+DSC::DSC(byte busNum)
+  : busNum(takeBus(busNum)), 
+    bus(this->busNum != DSC_NO_BUS ? dscBus[this->busNum] : noBus), 
+    timing(bus.timing), panel(bus.panel), keypad(bus.keypad), 
+    keysend(bus.keysend), capture(bus.capture), priority(bus.priority)
+  {
+    init();
+  }
+
+DSC::DSC(dscBus_t &state)
+  : busNum(DSC_DETACHED), bus(state), 
+    timing(bus.timing), panel(bus.panel), keypad(bus.keypad), 
+    keysend(bus.keysend), capture(bus.capture), priority(bus.priority)
+  {
+    init();
+  }
+
+DSC::~DSC(void)
+  {
+    if (busNum >= MAX_BUSES) return;        // No keybus taken
+    end();
+    busUsed &= ~(1 << busNum);              // The keybus may be taken again
+  }
+
+bool DSC::valid(void)
+  {
+    return busNum != DSC_NO_BUS;
+  }
+
+void DSC::init(void)
+  {
+    attached = false;
+
     // ----- Time Variables -----
     // Volatile variables, modified within ISR, based on micros()
     timing.intervalTimer = 0;   
@@ -57,34 +285,38 @@ DSC::DSC(void)
     timing.lastData = 0;
 
     // Class level variables to hold time elements
-    int yy = 0, mm = 0, dd = 0, HH = 0, MM = 0, SS = 0;
-    bool timeAvailable = false;     // Changes to true when kCmd == 0xa5 to 
+    yy = 0, mm = 0, dd = 0, HH = 0, MM = 0, SS = 0;
+    timeAvailable = false;          // Changes to true when kCmd == 0xa5 to 
                                     // indicate that the time elements are valid
 
     // ----- Input/Output Pins (DEFAULTS) ------
     //   These can be changed prior to DSC.begin() using functions below
-    CLK      = 3;    // Keybus Yellow (Clock Line)
-    DTA_IN   = 4;    // Keybus Green (Data Line via V divider)
-    DTA_OUT  = 8;    // Keybus Green Output (Data Line through driver)
-    LED      = 13;   // LED pin on the arduino Uno
+    bus.CLK      = 3;    // Keybus Yellow (Clock Line)
+    bus.DTA_IN   = 4;    // Keybus Green (Data Line via V divider)
+    bus.DTA_OUT  = 8;    // Keybus Green Output (Data Line through driver)
+    bus.LED      = 13;   // LED pin on the arduino Uno
 
     // ----- Keybus Word Byte Array Vars -----
     // Panel Array Data
-    wordSet(panel.newArray, 0, ARR_SIZE);
-    wordSet(panel.array, 0, ARR_SIZE);
-    wordSet(panel.oldArray, 0, ARR_SIZE);
+    wordSet(panel.newArray, 0, panel.size);
+    wordSet(panel.array, 0, panel.size);
+    wordSet(panel.oldArray, 0, panel.size);
     panel.bit = 0, panel.elem = 0;
+    panel.truncated = false, panel.overflows = 0;
     
     // Keypad Receive Data
-    wordSet(keypad.newArray, 0, ARR_SIZE);
-    wordSet(keypad.array, 0, ARR_SIZE);
-    wordSet(keypad.oldArray, 0, ARR_SIZE);
+    wordSet(keypad.newArray, 0, keypad.size);
+    wordSet(keypad.array, 0, keypad.size);
+    wordSet(keypad.oldArray, 0, keypad.size);
     keypad.bit = 0, keypad.elem = 0;
+    keypad.truncated = false, keypad.overflows = 0;
     
     // Keypad Send Data
-    wordSet(keysend.array, 0, 4);           // Send arrays only need 4 bytes of data MAX
+    wordSet(keysend.array, 0, keysend.size);  // Send arrays only need 4 bytes of data MAX
     keysend.bit = 0, keysend.elem = 0;
     keysend.waiting = false, keysend.ready = true, keysend.sent = false;
+    wordSet(keysend.logArray, 0, sizeof(keysend.logArray));
+    keysend.logLen = 0;
 
     // ----- Keybus Word Length Variables -----
     panel.newArrayLen = 0, panel.arrayLen = 0;
@@ -93,65 +325,222 @@ DSC::DSC(void)
 
     // ----- Keybus Command Byte Values -----
     panel.cmd = 0, keypad.cmd = 0;
+
+    // ----- Capture Queue and Process Pipeline -----
+    capture.head = 0, capture.tail = 0;
+    capture.dropped = 0, capture.shortWord = false;
+    stage = STAGE_IDLE;
+    pCmdPend = 0, kCmdPend = 0, pSum = 0;
+
+    // ----- Bit Resync -----
+    resync = true;
+    repaired = 0, unrecoverable = 0;
+
+    // ----- Priority Lane -----
+    priority.flags = 0, priority.level = 0, priority.stamp = 0;
+    priorityCb = NULL;
+    prioLatency = 0, prioLatencyMax = 0;
+
+    // ----- Word Ready -----
+    bus.readyHook = NULL;
+    bus.trace = NULL;
+    ledOn = false;
+
+    // ----- Latency -----
+    wordFirst = 0, wordLast = 0, wordHandoff = 0, wordLoaded = 0;
+    wordStamped = false;
+    clearLatency();
+
+    // ----- Event Coalescing -----
+    coalesceMs = 0, ratePerSec = 0;
+    for (byte i=0;i<COALESCE_SLOTS;i++) slots[i].source = 0xff;
+    for (byte i=0;i<2;i++) tokens[i] = 0, rateTime[i] = 0;
+    for (byte i=0;i<4;i++) suppressed[i] = 0;
+
+    // ----- Keypad Light State -----
+    partitions = 1;
+    for (byte i=0;i<MAX_PARTITIONS;i++) {
+      lights[i] = 0, lightsChanged[i] = 0;
+      state[i] = 0, stateChanged[i] = 0, user[i] = 0;
+    }
+
+    // ----- Event Subscriptions -----
+    for (byte i=0;i<MAX_SUBSCRIBERS;i++) subs[i].cb = NULL;
   }
 
 int DSC::addSerial(void)
   {
   // Not yet implemented
+    return 0;
   }
 
-void DSC::begin(void)
+bool DSC::begin(void)
   {
-    pinMode(CLK, INPUT);
-    pinMode(DTA_IN, INPUT);
-    pinMode(DTA_OUT, OUTPUT);
-    pinMode(LED, OUTPUT);
-
-    //tempByte.begin();       // Begin the generic tempByte buffer, allocate memory
-    wordBuf.begin();          // Begin the word buffer, allocate memory
-    pMsg.begin();             // Begin the panel message buffer, allocate memory
-    kMsg.begin();             // Begin the keypad message buffer, allocate memory
-    sendBuf.begin();          // Begin the keypad send word buffer, allocate memory
+    if (busNum >= MAX_BUSES) return 0;      // No keybus, see valid(), or decoder only
+    pinMode(bus.CLK, INPUT);
+    pinMode(bus.DTA_IN, INPUT);
+    pinMode(bus.DTA_OUT, OUTPUT);
+    pinMode(bus.LED, OUTPUT);
+    digitalWrite(bus.LED, 0);
+    ledOn = false;
 
     // Set the interrupt pin
-    intrNum = digitalPinToInterrupt(CLK);
-
-    // Attach interrupt on the CLK pin
-    attachInterrupt(intrNum, clkCalled_Handler, CHANGE);  
+    intrNum = digitalPinToInterrupt(bus.CLK);
+
+    // Attach the keybus's own interrupt handler on the CLK pin
+    void (*handler)(void) = clkCalled_Handler<0>;
+    if (busNum == 1) handler = clkCalled_Handler<(MAX_BUSES > 1) ? 1 : 0>;
+    if (busNum == 2) handler = clkCalled_Handler<(MAX_BUSES > 2) ? 2 : 0>;
+    if (busNum == 3) handler = clkCalled_Handler<(MAX_BUSES > 3) ? 3 : 0>;
+    attachInterrupt(intrNum, handler, CHANGE);  
     //   Changed from RISING to CHANGE to read both panel and keypad data
+    attached = true;
+    return 1;
   }
 
+#if defined(ESP32)
+/* Dual core mode (see DSC.beginDualCore()).  The ISR of keybus N wakes the decode
+ * task of that keybus with a task notification each time it hands off a word or 
+ * raises a priority flag, and the task runs process() until the pipeline is empty.  The ISR is attached from a
+ * short lived task on the capture core, as an interrupt is serviced on the core
+ * which attached it.
+ */
+static TaskHandle_t decodeTask[MAX_BUSES];
+
+template <byte N> void DSC_IRAM wordReadyNotify()
+  {
+    BaseType_t woken = pdFALSE;
+    if (decodeTask[N]) vTaskNotifyGiveFromISR(decodeTask[N], &woken);
+    if (woken) portYIELD_FROM_ISR();
+  }
+
+static void decodeLoop(void *arg)
+  {
+    DSC *dsc = (DSC *)arg;
+    for (;;) {
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(100));   // The timeout runs the timeouts
+      while (dsc->process() != -1);
+    }
+  }
+
+struct dscCaptureStart_t { DSC *dsc; TaskHandle_t caller; };
+
+static void captureStart(void *arg)
+  {
+    dscCaptureStart_t *start = (dscCaptureStart_t *)arg;
+    start->dsc->begin();
+    xTaskNotifyGive(start->caller);
+    vTaskDelete(NULL);
+  }
+
+bool DSC::beginDualCore(byte captureCore, byte decodeCore)
+  {
+    if (busNum >= MAX_BUSES) return 0;
+    if (decodeTask[busNum]) return 1;
+    if (xTaskCreatePinnedToCore(decodeLoop, "dscDecode", DSC_DECODE_STACK, this,
+                                DSC_DECODE_PRIO, &decodeTask[busNum], decodeCore) != pdPASS) {
+      decodeTask[busNum] = NULL;
+      return 0;
+    }
+    void (*hook)(void) = wordReadyNotify<0>;
+    if (busNum == 1) hook = wordReadyNotify<(MAX_BUSES > 1) ? 1 : 0>;
+    if (busNum == 2) hook = wordReadyNotify<(MAX_BUSES > 2) ? 2 : 0>;
+    if (busNum == 3) hook = wordReadyNotify<(MAX_BUSES > 3) ? 3 : 0>;
+    setWordReadyHook(hook);
+
+    // begin() on the capture core, and wait for it
+    dscCaptureStart_t start = { this, xTaskGetCurrentTaskHandle() };
+    if (xTaskCreatePinnedToCore(captureStart, "dscCapture", 2048, &start,
+                                configMAX_PRIORITIES - 1, NULL, captureCore) != pdPASS) {
+      begin();                              // On this core then
+      return 1;
+    }
+    ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+    return 1;
+  }
+#endif
+
 /* This is the interrupt handler used by this class. It is called every time the input
  * pin changes from high to low or from low to high.
  *
  * The function is not a member of the DSC class, it must be in the global scope in order 
- * to be called by attachInterrupt() from within the DSC class.
+ * to be called by attachInterrupt() from within the DSC class.  One copy is compiled
+ * for each keybus (N), so the address of its dscBus[N] block is a constant and there
+ * is no lookup on each clock edge.
  */
-void clkCalled_Handler() 
+template <byte N> void DSC_IRAM clkCalled_Handler() 
   { 
-    digitalWrite(DTA_OUT, 0);                 // Reset the data out line
-    timing.clockChange = micros();            // Save the current clock change time 
+    dscBus_t &bus = dscBus[N];
+    digitalWrite(bus.DTA_OUT, 0);             // Reset the data out line
+    clkEdge(bus, digitalRead(bus.CLK), digitalRead(bus.DTA_IN), micros());
+  }
+
+/* The work done on each clock edge, "clk" is the new clock line level, "data" is the 
+ * data line level and "now" is the time of the edge in micros.  Returns the data line
+ * level as seen by the panel (low while a keypad bit is being sent).
+ */
+static inline bool clkEdge(dscBus_t &bus, bool clk, bool data, unsigned long now)
+  { 
+    timing_t   &timing  = bus.timing;
+    panel_t    &panel   = bus.panel;
+    keypad_t   &keypad  = bus.keypad;
+    keysend_t  &keysend = bus.keysend;
+    capqueue_t &capture = bus.capture;
+    bool driven = false;                      // Data line pulled low to send a bit
+
+    timing.clockChange = now;                 // Save the current clock change time 
     timing.intervalTimer =  
         (timing.clockChange - timing.lastChange);   // Determine interval since last clock change 
     
     if (timing.intervalTimer > (NEW_WORD_INTV - 200)) { 
-      wordCpy(keypad.newArray, keypad.array, ARR_SIZE); // Save the complete keypad raw data bytes array 
-      keypad.arrayLen = keypad.newArrayLen;             // Copy the word length
+      /*
+       * Capture hand-off: this is the first edge of a new word, so the panel and
+       * keypad words just completed are queued for process() to decode. Words
+       * too short to decode are discarded here, and so are words which overflowed
+       * their buffer (counted in overflows), as their last bytes are missing.  The
+       * keypad word of an overflowed panel word goes with it, an overflowed keypad
+       * word alone is queued empty (skipped by the check stage).
+       */
+      if (panel.newArrayLen >= 8 && !panel.truncated) {
+        if ((byte)(capture.head - dscLoadAcquire(capture.tail)) < PIPE_DEPTH) {
+          capture_t &w = capture.word[capture.head % PIPE_DEPTH];
+          wordCpy(panel.newArray, w.pArray, panel.size); // Save the complete panel raw data bytes array
+          w.pLen = panel.newArrayLen;                   // Copy the word length
+          if (keypad.truncated) wordSet(w.kArray, 0, keypad.size);
+          else wordCpy(keypad.newArray, w.kArray, keypad.size); // Save the complete keypad raw data bytes array 
+          w.kLen = keypad.truncated ? 0 : keypad.newArrayLen;   // Copy the word length
+          w.first = timing.wordStart;                   // Stamp the word's edges
+          w.last = timing.lastChange;
+          w.handoff = now;
+          dscStoreRelease(capture.head, (byte)(capture.head + 1));  // Publish the word to process()
+          if (bus.readyHook) bus.readyHook();           // Wake whoever is waiting on it
+        }
+        else dscStoreRelease(capture.dropped, (unsigned int)(capture.dropped + 1));  // Queue is full, the word is lost
+      }
+      else if (panel.newArrayLen > 0 && panel.newArrayLen < 8) dscStoreRelease(capture.shortWord, true);
+      timing.wordStart = now;                 // This edge starts the next word
+
+      wordSet(panel.newArray, 0, panel.size); // Reset the raw data bytes panel array being built
+      panel.newArrayLen = 0;                  // Reset the new panel word length to zero
+      panel.truncated = false;                // Reset the panel overflow flag
+      panel.bit = 0;                          // Reset the panel bit counter to zero
+      panel.elem = 0;                         // Reset the panel byte counter to zero
       
-      wordSet(keypad.newArray, 0, ARR_SIZE);  // Reset the raw data bytes keypad array being built
+      wordSet(keypad.newArray, 0, keypad.size); // Reset the raw data bytes keypad array being built
       keypad.newArrayLen = 0;                 // Reset the new keypad word length to zero
+      keypad.truncated = false;               // Reset the keypad overflow flag
       keypad.bit = 0;				                  // Reset the keypad bit counter to zero
       keypad.elem = 0; 				                // Reset the keypad byte counter to zero
     } 
     timing.lastChange = timing.clockChange;   // Re-save the current change time as last change time 
     
-    if (digitalRead(CLK)) {                   // If clock line is going HIGH, this is PANEL data 
+    if (clk) {                                // If clock line is going HIGH, this is PANEL data 
       timing.lastRise = timing.lastChange;    // Set the lastRise time    
       
-      if (panel.elem < ARR_SIZE) {      	    // Limit the array to X bytes
+      if (panel.elem < panel.size) {          // Limit the array to X bytes
         //delayMicroseconds(120);             // Delay for 120 us to get a valid data line read 
         panel.newArray[panel.elem] <<= 1;
-        if (digitalRead(DTA_IN)) panel.newArray[panel.elem] |= 1; 
+        if (data) panel.newArray[panel.elem] |= 1; 
         panel.newArrayLen++;
         // Increment the panel elem (byte) and bit counters as required
         if (panel.elem == 0 and panel.bit == 7) { 
@@ -160,272 +549,537 @@ void clkCalled_Handler()
           panel.bit++;
         else { 
           panel.elem++; panel.bit = 0; }      // Increment pByte counter if 8 bits
+
+        // Priority lane, raised as soon as the bit is in (the rest of the status
+        // word is still being clocked in)
+        if (panel.newArray[0] == 0x05) {
+          if (panel.newArrayLen == 11)        // Bit 10, Fire
+            raisePriority(bus, PRIO_FIRE, panel.newArray[2] & 0x01, 1, now);
+          if (panel.newArrayLen == 23)        // Bits 21-22, Alarm
+            raisePriority(bus, PRIO_ALARM, (panel.newArray[3] & 0x03) == 0x03, 1, now);
+        }
       } 
+      else if (!panel.truncated) {            // Count the word as an overflow once
+        panel.truncated = true;
+        panel.overflows++;
+      }
     } 
     
     else {                                    // Otherwise, it's going LOW, this is KEYPAD data 
       timing.lastFall = timing.lastChange;    // Set the lastFall time 
       
-      if (keysend.waiting && keypad.newArrayLen == 0) {
+      if (dscLoadAcquire(keysend.waiting) && keypad.newArrayLen == 0) {
         // Send virtual keypad data
+        // Bits past the end of the send array are sent as zeros
         byte writeBit = 0;
-        if (keysend.bit == 0) if (keysend.array[keysend.elem] > 127) {
-          keysend.array[keysend.elem] -= 128; writeBit = 1; }
-        if (keysend.bit == 1) if (keysend.array[keysend.elem] > 63) {
-          keysend.array[keysend.elem] -= 64; writeBit = 1; }
-        if (keysend.bit == 2) if (keysend.array[keysend.elem] > 31) {
-          keysend.array[keysend.elem] -= 32; writeBit = 1; }
-        if (keysend.bit == 3) if (keysend.array[keysend.elem] > 15) {
-          keysend.array[keysend.elem] -= 16; writeBit = 1; }
-        if (keysend.bit == 4) if (keysend.array[keysend.elem] > 7) {
-          keysend.array[keysend.elem] -= 8; writeBit = 1; }
-        if (keysend.bit == 5) if (keysend.array[keysend.elem] > 3) {
-          keysend.array[keysend.elem] -= 4; writeBit = 1; }
-        if (keysend.bit == 6) if (keysend.array[keysend.elem] > 1) {
-          keysend.array[keysend.elem] -= 2; writeBit = 1; }
-        if (keysend.bit == 7) if (keysend.array[keysend.elem] > 0) {
-          keysend.array[keysend.elem] -= 1; writeBit = 1; }
-        if (writeBit == 0) digitalWrite(DTA_OUT, 1);  // Pull the data out line low
-        sendBuf.print(writeBit);                      // Write the bit to the send buffer
+        if (keysend.elem < keysend.size) 
+          writeBit = (keysend.array[keysend.elem] >> (7 - keysend.bit)) & 1;
+        if (writeBit == 0) {
+          digitalWrite(bus.DTA_OUT, 1);               // Pull the data out line low
+          data = 0;
+          driven = true;
+        }
+        byte n = keysend.logLen;                      // Record the bit, see get_sendRaw()
+        if (n < KSD_LOG_LEN) {
+          if (writeBit) keysend.logArray[n >> 3] |= 0x80 >> (n & 7);
+          dscStoreRelease(keysend.logLen, (byte)(n + 1));
+        }
         
         // Increment the keysend elem (byte) and bit counters as required
         if (keysend.bit < 7) 
           keysend.bit++;
         else { 
           keysend.elem++; keysend.bit = 0; }          // Increment kByte counter if 8 bits
-        if (keysend.elem == 4 && keysend.bit == 7) {  // Sending is complete
+        if (keysend.elem == keysend.size && keysend.bit == 7) {  // Sending is complete
           keysend.waiting = false;
-          keysend.ready = true;
           keysend.sent = true;
+          dscStoreRelease(keysend.ready, true);       // Last, send_key() may start another
         }
       }
       
-      else if (keypad.elem < ARR_SIZE) {      // Limit the array to X bytes  
+      else if (keypad.elem < keypad.size) {   // Limit the array to X bytes  
         //delayMicroseconds(200);             // Delay for 300 us to get a valid data line read 
         keypad.newArray[keypad.elem] <<= 1;
-        if (digitalRead(DTA_IN)) keypad.newArray[keypad.elem] |= 1;  
+        if (data) keypad.newArray[keypad.elem] |= 1;  
         keypad.newArrayLen++;
         // Increment the keypad elem (byte) and bit counters as required
         if (keypad.bit < 7) 
           keypad.bit++;
         else { 
           keypad.elem++; keypad.bit = 0; }    // Increment kByte counter if 8 bits
+
+        // Priority lane, the Fire, Aux and Panic buttons are known from the first byte
+        if (keypad.newArrayLen == 8) {
+          byte k = keypad.newArray[0];
+          if (k == fire)  raisePriority(bus, PRIO_KEY_FIRE, 1, 0, now);
+          if (k == aux)   raisePriority(bus, PRIO_KEY_AUX, 1, 0, now);
+          if (k == panic) raisePriority(bus, PRIO_KEY_PANIC, 1, 0, now);
+        }
+      }
+      else if (!keypad.truncated) {           // Count the word as an overflow once
+        keypad.truncated = true;
+        keypad.overflows++;
       }
     } 
+
+    if (bus.trace) {                          // Edge trace (see DSC_Trace)
+      trace_t &t = *bus.trace;
+      if ((unsigned int)(t.head - dscLoadAcquire(t.tail)) < t.size) {
+        traceEdge_t &e = t.buf[t.head & (t.size - 1)];
+        e.us = now;
+        e.lines = (clk ? TRACE_CLK : 0) | (data ? TRACE_DATA : 0) | (driven ? TRACE_KEYSEND : 0);
+        dscStoreRelease(t.head, t.head + 1);
+      }
+      else t.dropped++;
+    }
+    return data;
+  }
+
+static inline void raisePriority(dscBus_t &bus, byte flag, bool on, bool held, 
+                                 unsigned long now)
+  {
+    // Raises "flag" if "on", a "held" condition only when it starts, and wakes
+    // whoever is waiting on the keybus (the word is still being clocked in)
+    priority_t &prio = bus.priority;
+    if (held) {
+      bool was = prio.level & flag;
+      if (on) prio.level |= flag;
+      else prio.level &= ~flag;
+      if (was) return;
+    }
+    if (!on) return;
+    if (!dscLoadAcquire(prio.flags)) dscStoreRelease(prio.stamp, now);  // The latency is from the first flag
+    dscFetchOr(prio.flags, flag);
+    if (bus.readyHook) bus.readyHook();
   }
 
 // ----- The following are DSC class level functions -----
 
+bool DSC::injectEdge(bool clk, bool data, unsigned long us)
+  {
+    // Feeds a clock edge to this keybus as if it came from the ISR
+    if (busNum == DSC_NO_BUS) return data;
+    if (busNum != DSC_DETACHED) digitalWrite(bus.DTA_OUT, 0);   // Reset the data out line
+    return clkEdge(bus, clk, data, us);
+  }
+
+void DSC::replayWord(const byte* pArr, byte pLen, const byte* kArr, byte kLen)
+  {
+    // Copies the word into the panel and keypad arrays, as loadWord() does from
+    // the capture queue, and starts the pipeline on it
+    if (busNum == DSC_NO_BUS) return;
+    for (byte i=0;i<panel.size;i++) panel.array[i] = pArr[i];
+    panel.arrayLen = pLen;
+    for (byte i=0;i<keypad.size;i++) keypad.array[i] = kArr[i];
+    keypad.arrayLen = kLen;
+    wordSet(panel.oldArray, 0, panel.size);   // Don't skip it as a duplicate
+    wordFirst = wordLast = wordHandoff = wordLoaded = micros();
+    wordStamped = false;                      // No edges, so it isn't timed
+
+    stage = STAGE_CHECK;
+  }
+
+void DSC::end(void)
+  {
+    if (!attached) return;
+    detachInterrupt(intrNum);                 // Stop reading the keybus
+    attached = false;
+  }
+
 int DSC::process(void)
+  {
+    return process(0);          // Process the next word to completion
+  }
+
+int DSC::process(unsigned long budget_us)
   {
     // ------------ Get/process incoming data -------------
+    if (busNum == DSC_NO_BUS) return -1;      // No keybus, see valid()
+    unsigned long start = micros();
     panel.cmd = 0; 
     keypad.cmd = 0; 
-    timeAvailable = false;      // Set the time element status to invalid
     
+    // ------------------ Priority Lane -------------------
+    // Taken ahead of any queued word
+    if (dscLoadAcquire(priority.flags) && priorityCb) {
+      byte flags = getPriority();
+      priorityCb(flags, prioLatency);
+    }
+
     // ----------------- Turn on/off LED ------------------
-    if ((millis() - timing.lastStatus) > 500)
-      digitalWrite(LED, 0);     // Turn LED OFF (no recent status command [0x05])
-    else
-      digitalWrite(LED, 1);     // Turn LED ON  (recent status command [0x05])
+    // ON if there was a recent status command [0x05], only written when it changes
+    bool led = (millis() - timing.lastStatus) <= 500;
+    if (led != ledOn) {
+      if (busNum != DSC_DETACHED) digitalWrite(bus.LED, led);
+      ledOn = led;
+    }
     
     /*
      * The normal clock frequency is 1 Hz or one cycle every ms (1000 us) 
      * The new word marker is clock high for about 15 ms (15000 us)
-     * If the interval is longer than the required amount (NEW_WORD_INTV + 200 us), 
-     * and the panel word in progress (pBuild) is more than 8 characters long,
-     * process the panel and keypad words, otherwise return failure (0).
+     * The ISR hands each complete word off to the capture queue when it sees the
+     * new word marker, so if nothing has been queued the word is still being built.
      */
+    if (stage == STAGE_IDLE) {
+      if (dscExchange(capture.shortWord, false)) return -2;  // Complete word too short
+      if (!loadWord()) return -1;   // Still building word
+    }
 
-    if (timing.intervalTimer < (NEW_WORD_INTV + 200)) return -1;  // Still building word
-    if (panel.newArrayLen < 8) return -2;                         // Complete word too short
+    /*
+     * Run the pipeline stages in order, stopping between stages if the budget
+     * has been used up.  The stage reached is kept, so the next call resumes there.
+     */
+    int result = -3;
+    do {
+      result = runStage();
+    } while (stage != STAGE_IDLE && (!budget_us || (micros() - start) < budget_us));
 
-    wordCpy(panel.newArray, panel.array, ARR_SIZE); // Save the complete panel raw data bytes array 
-    panel.arrayLen = panel.newArrayLen;             // Copy the word length
-    
-    wordSet(panel.newArray, 0, ARR_SIZE);   // Reset the raw data bytes panel array being built
-    panel.newArrayLen = 0;                  // Reset the new panel word length to zero
-    panel.bit = 0;				                  // Reset the panel bit counter to zero
-    panel.elem = 0; 				                // Reset the panel byte counter to zero
-    
-    panel.cmd = decodePanel();              // Decode the panel binary, return command byte, or 0
-    keypad.cmd = decodeKeypad();            // Decode the keypad binary, return command byte, or 0
-    
-    if (panel.cmd && keypad.cmd) return 3;  // Return 3 if both were decoded
-    else if (keypad.cmd) return 2;          // Return 2 if keypad word was decoded
-    else if (panel.cmd) return 1;           // Return 1 if panel word was decoded
-    else return 0;                          // Return failure if none were decoded
+    return result;
+  }
+
+bool DSC::loadWord(void)
+  {
+    // Takes the oldest word from the capture queue into the panel and keypad 
+    // arrays, returns false if the queue is empty
+    if (dscLoadAcquire(capture.head) == capture.tail) return 0;
+
+    capture_t &w = capture.word[capture.tail % PIPE_DEPTH];
+    wordCpy(w.pArray, panel.array, panel.size); // Copy the panel raw data bytes array
+    panel.arrayLen = w.pLen;                    // Copy the word length
+    wordCpy(w.kArray, keypad.array, keypad.size); // Copy the keypad raw data bytes array
+    keypad.arrayLen = w.kLen;                   // Copy the word length
+    wordFirst = w.first;                        // Copy the edge times
+    wordLast = w.last;
+    wordHandoff = w.handoff;
+    wordLoaded = micros();
+    wordStamped = true;
+    dscStoreRelease(capture.tail, (byte)(capture.tail + 1));  // Free the slot for the ISR
+
+    stage = STAGE_CHECK;
+    return 1;
+  }
+
+int DSC::runStage(void)
+  {
+    // Runs the current pipeline stage, then advances to the next one
+    // Returns -3 until the format stage completes, then the process() result
+    switch (stage) {
+      case STAGE_CHECK:
+        // A new word, the time is valid again once an 0xa5 word has been through 
+        // the state stage (which may be in an earlier process() call than the end)
+        timeAvailable = false;
+        pCmdPend = checkPanel();            // Checksum and skip duplicate/empty words
+        kCmdPend = checkKeypad();
+        if (!wanted(DSC_PANEL, pCmdPend)) pCmdPend = 0;    // Skip words no callback wants
+        if (!wanted(DSC_KEYPAD, kCmdPend)) kCmdPend = 0;
+        if (pCmdPend || kCmdPend) stage = STAGE_DECODE;
+        else {
+          stage = STAGE_IDLE;
+          return 0;                         // Return failure if none are left to decode
+        }
+        break;
+
+      case STAGE_DECODE:
+        if (pCmdPend) decodePnlData(pCmdPend);
+        if (kCmdPend) decodeKpdData(kCmdPend);
+        stage = STAGE_STATE;
+        break;
+
+      case STAGE_STATE:
+        if (pCmdPend) updatePnlState(pCmdPend);
+        stage = STAGE_FORMAT;
+        break;
+
+      case STAGE_FORMAT:
+        if (coalesceMs) {                   // Skip the words coalesced away
+          if (pCmdPend && !coalesce(DSC_PANEL, pCmdPend)) pCmdPend = 0;
+          if (kCmdPend && !coalesce(DSC_KEYPAD, kCmdPend)) kCmdPend = 0;
+        }
+        if (pCmdPend) formatPanel(pCmdPend);
+        if (kCmdPend) formatKeypad(kCmdPend);
+        stage = STAGE_IDLE;
+
+        // ----- Dispatch -----
+        panel.cmd = pCmdPend;               // Make the word available to get_xxx() 
+        keypad.cmd = kCmdPend;
+        if (wordStamped && (panel.cmd || keypad.cmd)) {
+          latCount(LAT_HANDOFF, wordHandoff - wordLast);
+          latCount(LAT_QUEUE, wordLoaded - wordHandoff);
+          latCount(LAT_DELIVERY, micros() - wordLoaded);
+        }
+        if (panel.cmd) dispatch(DSC_PANEL, panel.cmd);
+        if (keypad.cmd) dispatch(DSC_KEYPAD, keypad.cmd);
+        if (panel.cmd && keypad.cmd) return 3;  // Return 3 if both were decoded
+        else if (keypad.cmd) return 2;          // Return 2 if keypad word was decoded
+        else if (panel.cmd) return 1;           // Return 1 if panel word was decoded
+        else return 0;                          // Return 0 if both were coalesced
+
+      default:
+        stage = STAGE_IDLE;
+        return 0;
+    }
+    return -3;                              // Word still in the pipeline
   }
 
 byte DSC::decodePanel(void) 
+  {
+    // Runs every pipeline stage on the current panel word
+    byte cmd = checkPanel();
+    if (!cmd) return 0;               // Return failure
+    decodePnlData(cmd);
+    updatePnlState(cmd);
+    formatPanel(cmd);
+    return cmd;                       // Return success
+  }
+
+byte DSC::decodeKeypad(void) 
+  {
+    // Runs every pipeline stage on the current keypad word
+    byte cmd = checkKeypad();
+    if (!cmd) return 0;               // Return failure
+    decodeKpdData(cmd);
+    formatKeypad(cmd);
+    return cmd;                       // Return success
+  }
+
+byte DSC::checkPanel(void) 
   {
     pMsg.clear();                     // Initialize panel message for output
     
-    // ------------- Process the Panel Data Word ---------------
+    // ------------- Check the Panel Data Word ---------------
     byte cmd = panel.array[0];        // Get the panel Cmd (data word type/command)
 
-    if (wordCmp(panel.array, panel.oldArray, ARR_SIZE) || cmd == 0x00) {
+    // Repair a word with a bad checksum before it is compared, the repeat of a
+    // good word is then skipped as usual
+    if (resync && cmd != 0x00 && !pnlChkValid()) {
+      for (byte i=0;i<sizeof(CHKSUM_CMDS);i++) {
+        if (cmd != CHKSUM_CMDS[i]) continue;
+        if (resyncPanel()) repaired++;
+        else {
+          unrecoverable++;
+          return 0;   // Return failure, the fields can't be trusted
+        }
+        break;
+      }
+    }
+
+    if (wordCmp(panel.array, panel.oldArray, panel.size) || cmd == 0x00) {
       // Skip this word if the data hasn't changed, or pCmd is empty (0x00)
       return 0;     // Return failure
     }
-    
-    else {     
-      // This seems to be a valid word, try to process it  
-      timing.lastData = millis();                     // Record the time (last data word was received)
-      wordCpy(panel.array, panel.oldArray, ARR_SIZE); // This is a new/good word, save it   
-
-      // ------ DEBUG FILTERING ------
-      //if (cmd != 0x05 && cmd != 0x34 && cmd != 0xa5) return 0;
-      // -----------------------------
-
-      /* 
-       *  This section needs your help!  If you have time, please try to figure out 
-       *  what unknown command codes/words mean, and what data they contain!
-       */
-      if (cmd == 0x05) 
-      {
-        timing.lastStatus = millis();           // Record the time for LED logic
-        pMsg.print(F("[Status] "));
-        if (byteToInt(panel.array,16,1,1))      pMsg.print(F("Ready"));
-        else  {                                  
-          if (byteToInt(panel.array,15,1,1))    pMsg.print(F("Armed"));
-          else                                  pMsg.print(F("Not Ready")); }
-        if (byteToInt(panel.array,10,1,1))      pMsg.print(F(", Fire"));
-        if (byteToInt(panel.array,12,1,1))      pMsg.print(F(", Error"));
-        if (byteToInt(panel.array,13,1,1))      pMsg.print(F(", Bypass"));
-        if (byteToInt(panel.array,14,1,1))      pMsg.print(F(", Memory"));
-        if (byteToInt(panel.array,17,1,1))      pMsg.print(F(", Program"));
-        if (byteToInt(panel.array,29,1,1))      pMsg.print(F(", Power Fail"));   // ??? - maybe 28 or 20?
-      
-        // ---------- These are in question ----------
-        if (byteToInt(panel.array,21,2,1) == 2) pMsg.print(F(", Exit Delay"));
-        if (byteToInt(panel.array,21,2,1) == 3) pMsg.print(F(", Alarm"));
-      
+
+    // This seems to be a valid word, try to process it  
+    timing.lastData = millis();                     // Record the time (last data word was received)
+    if (cmd == 0x05) timing.lastStatus = millis();  // Record the time for LED logic
+    wordCpy(panel.array, panel.oldArray, panel.size); // This is a new/good word, save it   
+    pSum = pnlChkValid();                           // Save the checksum test for the formatters
+
+    // ------ DEBUG FILTERING ------
+    //if (cmd != 0x05 && cmd != 0x34 && cmd != 0xa5) return 0;
+    // -----------------------------
+
+    return cmd;     // Return success
+  }
+
+void DSC::decodePnlData(byte cmd) 
+  {
+    /* 
+     *  This section needs your help!  If you have time, please try to figure out 
+     *  what unknown command codes/words mean, and what data they contain!
+     *  The fields are listed in the schema (pnlFields) above.
+     */
+    pData = pnlData_t();
+
+    // One pass over the command's fields in the schema for each partition, each 
+    // partition's fields are PART_BITS after the one before, partitions the word
+    // is too short for aren't decoded
+    byte first = pnlFirst(cmd);
+    byte end = 0;                               // Bits used by the partition fields
+    for (byte p=0;p<partitions;p++) {
+      byte o = p * PART_BITS;
+      if (p > 0 && (!end || panel.arrayLen < end + o)) break;
+      for (byte i=first;i<PNL_FIELDS && pgm_read_byte(&pnlFields[i].cmd) == cmd;i++) {
+        const pnlField_t &f = pnlFields[i];
+        byte part = pgm_read_byte(&f.part);
+        if (!pnlPartOn(part, p, partitions)) continue;
+        byte offset = pgm_read_byte(&f.offset), width = pgm_read_byte(&f.width);
+        if (part == PART_EACH && offset + width > end) end = offset + width;
+        unsigned int v = byteToInt(panel.array, offset + o, width, 1);
+        setField(pgm_read_byte(&f.dest), pgm_read_byte(&f.arg), p, v);
+        if (v < 4) pData.state[p] |= pgm_read_byte(&f.state[v]);
       }
-     
-      if (cmd == 0xa5)
-      {
-        pMsg.print(F("[Info] "));
-        
-        int y3 = byteToInt(panel.array,9,4,1);
-        int y4 = byteToInt(panel.array,13,4,1);
-        yy = (String(y3) + String(y4)).toInt();
-        mm = byteToInt(panel.array,19,4,1);
-        dd = byteToInt(panel.array,23,5,1);
-        HH = byteToInt(panel.array,28,5,1);
-        MM = byteToInt(panel.array,33,6,1);     
-
-        timeAvailable = true;         // Set the time element status to valid
-
-        byte arm = byteToInt(panel.array,41,2,1);
-        byte master = byteToInt(panel.array,43,1,1);
-        byte user = byteToInt(panel.array,43,6,1); // 0-36
-        if (arm == 0x02) {
-          pMsg.print(F("Armed"));
-          user = user - 0x19;
-        }
-        if (arm == 0x03) {
-          pMsg.print(F("Disarmed"));
-        }
-        if (arm > 0) {
-          if (master) pMsg.print(F(", Master Code")); 
-          else        pMsg.print(F(", User Code"));
-          user += 1;                  // shift to 1-32, 33, 34
-          if (user > 34) user += 5;   // convert to system code 40, 41, 42
-          pMsg.print(" "); pMsg.print(user);
-        }
+      pData.partitions++;
+    }
+  }
+
+void DSC::updatePnlState(byte cmd) 
+  {
+    // The same pass over the schema, each field keeps its part of the class state
+    byte first = pnlFirst(cmd);
+    for (byte p=0;p<pData.partitions;p++) {
+      for (byte i=first;i<PNL_FIELDS && pgm_read_byte(&pnlFields[i].cmd) == cmd;i++) {
+        const pnlField_t &f = pnlFields[i];
+        if (!pnlPartOn(pgm_read_byte(&f.part), p, partitions)) continue;
+        byte mask = 0;                          // The state bits of this field
+        for (byte v=0;v<4;v++) mask |= pgm_read_byte(&f.state[v]);
+        keepField(pgm_read_byte(&f.dest), pgm_read_byte(&f.arg), p, mask);
       }
-      
-      if (cmd == 0x27)
-      {
-        pMsg.print(F("[Zones A] "));
-        int zones = byteToInt(panel.array,8+1+8+8+8+8,8,1);
-        if (zones & 1) pMsg.print("1 ");
-        if (zones & 2) pMsg.print("2 ");
-        if (zones & 4) pMsg.print("3 ");
-        if (zones & 8) pMsg.print("4 ");
-        if (zones & 16) pMsg.print("5 ");
-        if (zones & 32) pMsg.print("6 ");
-        if (zones & 64) pMsg.print("7 ");
-        if (zones & 128) pMsg.print("8 ");
-        if (zones == 0) pMsg.print("Secure ");
+    }
+  }
+
+void DSC::formatPanel(byte cmd) 
+  {
+    if (cmd == 0x05) 
+    {
+      pMsg.print(F("[Status] "));
+      formatStatus(0);
+      for (byte p=1;p<pData.partitions;p++) {
+        pMsg.print(F(" | [Partition ")); pMsg.print(p + 1); pMsg.print(F("] "));
+        formatStatus(p);
       }
-      
-      if (cmd == 0x2d)
-      {
-        pMsg.print(F("[Zones B] "));
-        int zones = byteToInt(panel.array,8+1+8+8+8+8,8,1);
-        if (zones & 1) pMsg.print("9 ");
-        if (zones & 2) pMsg.print("10 ");
-        if (zones & 4) pMsg.print("11 ");
-        if (zones & 8) pMsg.print("12 ");
-        if (zones & 16) pMsg.print("13 ");
-        if (zones & 32) pMsg.print("14 ");
-        if (zones & 64) pMsg.print("15 ");
-        if (zones & 128) pMsg.print("16 ");
-        if (zones == 0) pMsg.print("Secure ");
+    }
+   
+    if (cmd == 0xa5)
+    {
+      pMsg.print(F("[Info] "));
+      if (pData.arm > 0) {
+        formatFields(cmd, 0);                     // Armed/Disarmed, Master/User Code
+        pMsg.print(" "); pMsg.print(pData.user);
       }
-      
-      if (cmd == 0x34)
-      {
-        pMsg.print(F("[Zones C] "));
-        int zones = byteToInt(panel.array,8+1+8+8+8+8,8,1);
-        if (zones & 1) pMsg.print("17 ");
-        if (zones & 2) pMsg.print("18 ");
-        if (zones & 4) pMsg.print("19 ");
-        if (zones & 8) pMsg.print("20 ");
-        if (zones & 16) pMsg.print("21 ");
-        if (zones & 32) pMsg.print("22 ");
-        if (zones & 64) pMsg.print("23 ");
-        if (zones & 128) pMsg.print("24 ");
-        if (zones == 0) pMsg.print("Secure ");
+      if (partitions > 1 && pData.partition) {
+        pMsg.print(F(", Partition ")); pMsg.print(pData.partition);
       }
-      
-      if (cmd == 0x3e)
-      {
-        pMsg.print(F("[Zones D] "));
-        int zones = byteToInt(panel.array,8+1+8+8+8+8,8,1);
-        if (zones & 1) pMsg.print("25 ");
-        if (zones & 2) pMsg.print("26 ");
-        if (zones & 4) pMsg.print("27 ");
-        if (zones & 8) pMsg.print("28 ");
-        if (zones & 16) pMsg.print("29 ");
-        if (zones & 32) pMsg.print("30 ");
-        if (zones & 64) pMsg.print("31 ");
-        if (zones & 128) pMsg.print("32 ");
-        if (zones == 0) pMsg.print("Secure ");
-      }
-      // --- The other 32 zones for a 1864 panel need to be added after this ---
-      //     - the hex command codes for these are unknown as far as I know
-
-      if (cmd == 0x11) 
-        pMsg.print(F("[Keypad Query] "));
-      if (cmd == 0x0a)
-        pMsg.print(F("[Panel Program Mode] "));
-      if (cmd == 0x5d)
-        pMsg.print(F("[Alarm Memory Group 1] "));
-      if (cmd == 0x63)
-        pMsg.print(F("[Alarm Memory Group 2] "));
-      if (cmd == 0x64)
-        pMsg.print(F("[3 Beeps] "));   //[Beep Command Group 1]
-      if (cmd == 0x69)
-        pMsg.print(F("[Beep Command Group 2] "));
-      if (cmd == 0x39)
-        pMsg.print(F("[Unknown Command] "));
-      if (cmd == 0xb1)
-        pMsg.print(F("[Zone Configuration] "));
-        
-    return cmd;     // Return success
     }
+    
+    // Zone words, the zone number of bit 0 is the first zone of the group
+    byte first = 0;
+    if (cmd == 0x27) { pMsg.print(F("[Zones A] ")); first = 1;  }
+    if (cmd == 0x2d) { pMsg.print(F("[Zones B] ")); first = 9;  }
+    if (cmd == 0x34) { pMsg.print(F("[Zones C] ")); first = 17; }
+    if (cmd == 0x3e) { pMsg.print(F("[Zones D] ")); first = 25; }
+    // --- The other 32 zones for a 1864 panel need to be added after this ---
+    //     - the hex command codes for these are unknown as far as I know
+    if (first) {
+      for (byte i=0;i<8;i++) {
+        if (pData.zones & (1 << i)) { pMsg.print(first + i); pMsg.print(" "); }
+      }
+      if (pData.zones == 0) pMsg.print(F("Secure "));
+    }
+
+    if (cmd == 0x11) 
+      pMsg.print(F("[Keypad Query] "));
+    if (cmd == 0x0a)
+      pMsg.print(F("[Panel Program Mode] "));
+    if (cmd == 0x5d)
+      pMsg.print(F("[Alarm Memory Group 1] "));
+    if (cmd == 0x63)
+      pMsg.print(F("[Alarm Memory Group 2] "));
+    if (cmd == 0x64)
+      pMsg.print(F("[3 Beeps] "));   //[Beep Command Group 1]
+    if (cmd == 0x69)
+      pMsg.print(F("[Beep Command Group 2] "));
+    if (cmd == 0x39)
+      pMsg.print(F("[Unknown Command] "));
+    if (cmd == 0xb1)
+      pMsg.print(F("[Zone Configuration] "));
   }
 
-byte DSC::decodeKeypad(void) 
+void DSC::formatStatus(byte p) 
+  {
+    byte l = pData.lights[p];
+    if (l & LIGHT_READY)                      pMsg.print(F("Ready"));
+    else  {                                  
+      if (l & LIGHT_ARMED)                    pMsg.print(F("Armed"));
+      else                                    pMsg.print(F("Not Ready")); }
+    formatFields(0x05, p);                    // The lights and conditions
+  }
+
+void DSC::setField(byte dest, byte arg, byte p, unsigned int v) 
+  {
+    switch (dest) {
+      case FLD_LIGHT:       if (v) pData.lights[p] |= arg;  break;
+      case FLD_EXIT_ALARM:  pData.exitAlarm[p] = v;         break;
+      case FLD_POWER_FAIL:  pData.powerFail = v;            break;
+      case FLD_ZONES:       pData.zones = v;                break;
+      case FLD_YEAR:        pData.yy += v * arg;            break;
+      case FLD_MONTH:       pData.mm = v;                   break;
+      case FLD_DAY:         pData.dd = v;                   break;
+      case FLD_HOUR:        pData.HH = v;                   break;
+      case FLD_MINUTE:      pData.MM = v;                   break;
+      case FLD_PARTITION:   pData.partition = v;            break;
+      case FLD_ARM:         pData.arm = v;                  break;
+      case FLD_MASTER:      pData.master = v;               break;
+      case FLD_USER:
+        // The code number, less "arg" when armed, as decoded after the arm field
+        if (pData.arm > 0) {
+          byte u = v - (pData.arm == 0x02 ? arg : 0) + 1;   // shift to 1-32, 33, 34
+          if (u > 34) u += 5;                 // convert to system code 40, 41, 42
+          v = u;
+        }
+        pData.user = v;
+        break;
+    }
+  }
+
+void DSC::keepField(byte dest, byte arg, byte p, byte stateBits) 
+  {
+    // Flag the light and state bits which changed, for each partition on its own
+    stateChanged[p] |= (state[p] ^ pData.state[p]) & stateBits;
+    state[p] ^= (state[p] ^ pData.state[p]) & stateBits;
+
+    switch (dest) {
+      case FLD_LIGHT:
+        lightsChanged[p] |= (lights[p] ^ pData.lights[p]) & arg;
+        lights[p] ^= (lights[p] ^ pData.lights[p]) & arg;
+        break;
+      case FLD_YEAR:        yy = pData.yy;                  break;
+      case FLD_MONTH:       mm = pData.mm;                  break;
+      case FLD_DAY:         dd = pData.dd;                  break;
+      case FLD_HOUR:        HH = pData.HH;                  break;
+      case FLD_MINUTE:      
+        MM = pData.MM;
+        timeAvailable = true;                 // Set the time element status to valid
+        break;
+      case FLD_USER: {
+        byte q = pData.partition ? pData.partition : 1;   // Not given on one partition
+        if (pData.arm > 0 && q <= MAX_PARTITIONS) user[q - 1] = pData.user;
+        break; }
+    }
+  }
+
+unsigned int DSC::getField(byte dest, byte arg, byte p) 
+  {
+    switch (dest) {
+      case FLD_LIGHT:       return (pData.lights[p] & arg) != 0;
+      case FLD_EXIT_ALARM:  return pData.exitAlarm[p];
+      case FLD_POWER_FAIL:  return pData.powerFail;
+      case FLD_ARM:         return pData.arm;
+      case FLD_MASTER:      return pData.master;
+    }
+    return 0;                                 // Not printed by name
+  }
+
+void DSC::formatFields(byte cmd, byte p) 
+  {
+    // Prints the text of each of the command's field values which has one
+    for (byte i=pnlFirst(cmd);i<PNL_FIELDS && pgm_read_byte(&pnlFields[i].cmd) == cmd;i++) {
+      const pnlField_t &f = pnlFields[i];
+      if (!pnlPartOn(pgm_read_byte(&f.part), p, partitions)) continue;
+      unsigned int v = getField(pgm_read_byte(&f.dest), pgm_read_byte(&f.arg), p);
+      const char *s = f.names;
+      for (char c;v && (c = pgm_read_byte(s));s++) if (c == '|') v--;
+      char c = pgm_read_byte(s);
+      if (v || !c || c == '|') continue;      // No text for the value
+      for (;c && c != '|';c = pgm_read_byte(++s)) pMsg.print(c);
+    }
+  }
+
+byte DSC::checkKeypad(void) 
   {
     kMsg.clear();                       // Initialize keypad message for output 
     
-    // ------------- Process the Keypad Data Word ---------------
+    // ------------- Check the Keypad Data Word ---------------
     byte cmd = keypad.array[0];         // Get the keypad Cmd (data word type/command)
-    String btnStr = F("[Button] ");
     
     if ((keypad.array[0] == 255 && keypad.array[1] == 255 &&
          keypad.array[2] == 255) || (keypad.array[0] == 0x00)) {  
@@ -433,71 +1087,41 @@ byte DSC::decodeKeypad(void)
       return 0;     // Return failure
     }
 
-    else { 
-      // This seems to be a valid word, try to process it
-      timing.lastData = millis();                       // Record the time (last data word was received)
-      wordCpy(keypad.array, keypad.oldArray, ARR_SIZE); // This is a new/good word, save it   
-
-      byte kByte2 = keypad.array[1]; 
-      byte kByte3 = keypad.array[2];
-      byte kByte4 = keypad.array[3];
-     
-      // Interpret the data
-      if (cmd == kOut) {
-        if (kByte2 == one) {
-          kMsg.print(btnStr); kMsg.print("1"); }
-        else if (kByte2 == two) {
-          kMsg.print(btnStr); kMsg.print("2"); }
-        else if (kByte2 == three) {
-          kMsg.print(btnStr); kMsg.print("3"); }
-        else if (kByte2 == four) {
-          kMsg.print(btnStr); kMsg.print("4"); }
-        else if (kByte2 == five) {
-          kMsg.print(btnStr); kMsg.print("5"); }
-        else if (kByte2 == six) {
-          kMsg.print(btnStr); kMsg.print("6"); }
-        else if (kByte2 == seven) {
-          kMsg.print(btnStr); kMsg.print("7"); }
-        else if (kByte2 == eight) {
-          kMsg.print(btnStr); kMsg.print("8"); }
-        else if (kByte2 == nine) {
-          kMsg.print(btnStr); kMsg.print("9"); }
-        else if (kByte2 == aster) {
-          kMsg.print(btnStr); kMsg.print("*"); }
-        else if (kByte2 == zero) {
-          kMsg.print(btnStr); kMsg.print("0"); }
-        else if (kByte2 == pound) {
-          kMsg.print(btnStr); kMsg.print("#"); }
-        else if (kByte2 == stay) {
-          kMsg.print(btnStr); kMsg.print(F("Stay")); }
-        else if (kByte2 == away) {
-          kMsg.print(btnStr); kMsg.print(F("Away")); }
-        else if (kByte2 == chime) {
-          kMsg.print(btnStr); kMsg.print(F("Chime")); }
-        else if (kByte2 == reset) {
-          kMsg.print(btnStr); kMsg.print(F("Reset")); }
-        else if (kByte2 == kExit) {
-          kMsg.print(btnStr); kMsg.print(F("Exit")); }
-        else if (kByte2 == lArrow) {  // These arrow commands don't work every time
-          kMsg.print(btnStr); kMsg.print(F("<")); }
-        else if (kByte2 == rArrow) {  // They are often reverse for unknown reasons
-          kMsg.print(btnStr); kMsg.print(F(">")); }
-        else if (kByte2 == kOut)
-          kMsg.print(F("[Keypad Response]"));
-        else {
-          kMsg.print("[Keypad] 0x"); 
-          kMsg.print(String(kByte2, HEX)); kMsg.print(" (Unknown)");
-        }
-      }
+    // This seems to be a valid word, try to process it
+    timing.lastData = millis();                       // Record the time (last data word was received)
+    wordCpy(keypad.array, keypad.oldArray, keypad.size); // This is a new/good word, save it   
 
-      if (cmd == fire) {
-        kMsg.print(btnStr); kMsg.print(F("Fire")); }
-      if (cmd == aux) {
-        kMsg.print(btnStr); kMsg.print(F("Aux")); }
-      if (cmd == panic) {
-        kMsg.print(btnStr); kMsg.print(F("Panic")); }
-      
-      return cmd;                         // Return success
+    return cmd;     // Return success
+  }
+
+void DSC::decodeKpdData(byte cmd) 
+  {
+    byte kByte2 = keypad.array[1]; 
+    kData.code = kByte2;
+    kData.key = KEY_NONE;
+   
+    // Interpret the data, one lookup for the keys sent after kOut, Fire/Aux/Panic
+    // are known from the 1st byte
+    if (cmd == kOut) kData.key = pgm_read_byte(&kpdCodeKey[kByte2]);
+    else {
+      for (byte k=KEY_FIRE;k<KEY_COUNT;k++)
+        if (cmd == pgm_read_byte(&kpdKeys[k].first)) kData.key = k;
+    }
+    kData.btn = kData.key ? (const __FlashStringHelper*)kpdKeys[kData.key].name : NULL;
+  }
+
+void DSC::formatKeypad(byte cmd) 
+  {
+    if (kData.btn) {
+      kMsg.print(F("[Button] ")); kMsg.print(kData.btn); }
+    else if (cmd == kOut) {
+      if (kData.code == kOut)
+        kMsg.print(F("[Keypad Response]"));
+      else {
+        kMsg.print(F("[Keypad] 0x"));       // Lower case, no leading 0
+        if (kData.code > 0x0f) kMsg.print(hex[kData.code >> 4]);
+        kMsg.print(hex[kData.code & 0x0f]); kMsg.print(F(" (Unknown)"));
+      }
     }
   }
 
@@ -527,7 +1151,7 @@ const char* DSC::get_pnlFormat(void)
     else
       wordBuf.print(byteToBin(panel.array[0], bitsRem));
 
-    if (pnlChkSum()) wordBuf.print(" (OK)");
+    if (pSum) wordBuf.print(" (OK)");
 
     return wordBuf.getBuffer();           // return the pointer
   }
@@ -579,7 +1203,7 @@ const char* DSC::get_pnlArray(void)
     else
       wordBuf.print(panel.array[0]);
 
-    if (pnlChkSum()) wordBuf.print(" (OK)");
+    if (pSum) wordBuf.print(" (OK)");
 
     return wordBuf.getBuffer();           // return the pointer
   }
@@ -626,7 +1250,7 @@ const char* DSC::get_pnlRaw(void)
     else
       wordBuf.print(byteToBin(panel.array[0], bitsRem));
 
-    if (pnlChkSum()) wordBuf.print(" (OK)");
+    if (pSum) wordBuf.print(" (OK)");
 
     return wordBuf.getBuffer();           // return the pointer
   }
@@ -653,26 +1277,122 @@ const char* DSC::get_kpdRaw(void)
     return wordBuf.getBuffer();           // return the pointer
   }
 
+const char* DSC::get_sendRaw(void)
+  {
+    // The bits are recorded by the ISR as they are sent, and only formatted here
+    byte len = dscLoadAcquire(keysend.logLen);
+    if (!len) return NULL;                // return failure
+    sendBuf.clear();
+    for (byte n=0;n<len;n++) 
+      sendBuf.print((keysend.logArray[n >> 3] & (0x80 >> (n & 7))) ? '1' : '0');
+    return sendBuf.getBuffer();           // return the pointer
+  }
+
 int DSC::pnlChkSum(void)
   {
-    // Sums all but the last full byte (minus padding) and compares 
-    // the remainder (modulo) to last byte
     // returns 0 if not valid, and the checksum if it's valid
-    int cSum = 0;
-    if (panel.arrayLen >= 17) {
-      cSum += panel.array[0];
-      int grps = (panel.arrayLen - 9) / 8; 
-      for(int i=0;i<grps;i++) {
-        if (i<(grps-1)) 
-          cSum += panel.array[i + 2];
-        else {
-          byte cSumMod = cSum % 256;
-          byte lastByte = panel.array[i + 2];
-          if (cSumMod == lastByte) return cSumMod;
+    return wordChkSum(panel.array, panel.arrayLen);
+  }
+
+bool DSC::pnlChkValid(void)
+  {
+    return wordChkOk(panel.array, panel.arrayLen);
+  }
+
+int wordChkSum(const volatile byte *a, int len)
+  {
+    // returns 0 if not valid, and the checksum if it's valid
+    return wordChkOk(a, len) ? a[(len - 9) / 8 + 1] : 0;
+  }
+
+bool wordChkOk(const volatile byte *a, int len)
+  {
+    // Sums all but the last full byte (minus padding) and compares 
+    // the remainder (modulo) to last byte, a checksum of 0x00 is valid too
+    if (len < 17) return 0;
+    int grps = (len - 9) / 8; 
+    byte cSum = a[0];
+    for (int i=0;i<grps-1;i++) cSum += a[i + 2];
+    return cSum == a[grps + 1];
+  }
+
+bool DSC::wordBit(const volatile byte* a, byte len, byte n, bool padding)
+  {
+    // A panel word is the command, one padding bit, then the data bytes, and the
+    // bits of a partial last byte are in its low end (they are shifted in from the 
+    // right)
+    if (padding) {
+      if (n < 8) return (a[0] >> (7 - n)) & 1;
+      if (n == 8) return a[1] & 1;
+      a += 2, n -= 9, len -= 9;
+    }
+    byte bits = len - (n & ~7);           // Bits in this byte
+    if (bits > 8) bits = 8;
+    return (a[n / 8] >> (bits - 1 - n % 8)) & 1;
+  }
+
+static void pnlAppend(byte *a, byte n, bool b)
+  {
+    // Shifts in bit "n" of a panel word, as the ISR does
+    byte e = (n < 8) ? 0 : (n == 8) ? 1 : 2 + (n - 9) / 8;
+    a[e] = (a[e] << 1) | b;
+  }
+
+bool DSC::resyncPanel(void)
+  {
+    /*
+     * A missed clock edge drops a bit and an extra one (noise) adds a bit, and either
+     * shifts every bit after it.  Each single bit insertion and deletion after the 
+     * padding bit is tried, and the word is repaired only if exactly one distinct
+     * word has a valid checksum.  Returns 1 if the word was repaired.
+     */
+    byte len = panel.arrayLen;
+    byte cand[PNL_ARR_SIZE], found[PNL_ARR_SIZE];
+    byte foundLen = 0, fixes = 0;
+    const byte maxLen = 9 + (PNL_ARR_SIZE - 2) * 8;
+
+    if (len < 17 || len > maxLen) return 0;
+    for (byte j=9;j<=len && fixes<2;j++) {
+      for (byte k=0;k<3 && fixes<2;k++) {   // 0: delete bit j, 1/2: insert a 0/1 at bit j
+        if ((k == 0 && j == len) || (k > 0 && len == maxLen)) continue;
+
+        // Build the candidate word bit by bit
+        wordSet(cand, 0, PNL_ARR_SIZE);
+        byte n = 0;
+        for (byte i=0;i<=len;i++) {
+          if (i == j && k) pnlAppend(cand, n++, k == 2);   // Inserted bit
+          if (i == len) break;
+          if (i == j && !k) continue;                      // Deleted bit
+          pnlAppend(cand, n++, wordBit(panel.array, len, i, 1));
         }
+
+        if (cand[0] != panel.array[0] || !wordChkOk(cand, n)) continue;
+        if (fixes && n == foundLen && wordCmp(cand, found, PNL_ARR_SIZE)) continue;
+        wordCpy(cand, found, PNL_ARR_SIZE);
+        foundLen = n;
+        fixes++;
       }
     }
-    return 0;
+    if (fixes != 1) return 0;
+
+    wordCpy(found, panel.array, panel.size);  // Replace the word with the repaired one
+    panel.arrayLen = foundLen;
+    return 1;
+  }
+
+void DSC::setResync(bool on)
+  {
+    resync = on;
+  }
+
+unsigned int DSC::get_repaired(void)
+  {
+    return repaired;
+  }
+
+unsigned int DSC::get_unrecoverable(void)
+  {
+    return unrecoverable;
   }
 
 const char* DSC::get_pMsg(void)
@@ -697,24 +1417,441 @@ byte DSC::get_kCmd(void)
     return keypad.cmd;                    // return kCmd
   }
 
+int DSC::subscribe(dscCallback_t cb, byte source, const byte* filter)
+  {
+    if (!cb || source > DSC_KEYPAD) return -1;  // return failure
+    for (byte i=0;i<MAX_SUBSCRIBERS;i++) {
+      if (subs[i].cb) continue;
+      subs[i].source = source;
+      subs[i].filter = filter;
+      subs[i].cb = cb;
+      return i;                             // return the subscription number
+    }
+    return -1;                              // return failure, no free slot
+  }
+
+bool DSC::unsubscribe(int id)
+  {
+    if (id < 0 || id >= MAX_SUBSCRIBERS || !subs[id].cb) return 0;
+    subs[id].cb = NULL;
+    return 1;
+  }
+
+void DSC::filterClear(byte* filter)
+  {
+    for (byte n=0;n<32;n++) filter[n] = 0;
+  }
+
+void DSC::filterAdd(byte* filter, byte cmd)
+  {
+    filter[cmd >> 3] |= (1 << (cmd & 7));
+  }
+
+bool DSC::filterHas(const byte* filter, byte cmd)
+  {
+    if (!filter) return 1;                  // No filter, all commands are wanted
+    return filter[cmd >> 3] & (1 << (cmd & 7));
+  }
+
+void DSC::decodeBatch(dscBatch_t &batch)
+  {
+    // The words are taken BATCH_CHUNK at a time and copied into local arrays, which
+    // the result arrays can't alias, so each step is a loop along the chunk without
+    // branches which can be vectorized.  The results are copied out at the end.
+    for (unsigned int base=0;base<batch.count;base+=BATCH_CHUNK) {
+      byte n = (batch.count - base < BATCH_CHUNK) ? batch.count - base : BATCH_CHUNK;
+      byte len[BATCH_CHUNK], row[PNL_ARR_SIZE][BATCH_CHUNK];
+      byte sum[BATCH_CHUNK], chk[BATCH_CHUNK], last[BATCH_CHUNK];
+      byte valid[BATCH_CHUNK], cls[BATCH_CHUNK], lights[BATCH_CHUNK];
+      unsigned long zones[BATCH_CHUNK];
+
+      const byte *inLen = batch.len + base;
+      for (byte w=0;w<n;w++) len[w] = inLen[w];
+      for (byte i=0;i<PNL_ARR_SIZE;i++) {
+        const byte *in = batch.bytes[i] + base;
+        for (byte w=0;w<n;w++) row[i][w] = in[w];
+      }
+      const byte *cmd = row[0];
+
+      // ----- Checksum, as wordChkSum() -----
+      // The last full byte is the checksum of the command and the bytes before it
+      for (byte w=0;w<n;w++) {
+        last[w] = (len[w] >= 17) ? 1 + (len[w] - 9) / 8 : 0;
+        sum[w] = cmd[w];
+        chk[w] = 0;
+      }
+      for (byte i=2;i<PNL_ARR_SIZE;i++) {
+        for (byte w=0;w<n;w++) {
+          byte add = -(byte)(i < last[w]), take = -(byte)(i == last[w]);   // 0 or 0xff
+          sum[w] += row[i][w] & add;
+          chk[w] = (row[i][w] & take) | (chk[w] & ~take);
+        }
+      }
+      for (byte w=0;w<n;w++) valid[w] = (last[w] && sum[w] == chk[w]) ? 1 : 0;
+
+      // ----- Command Class -----
+      // The zone commands are added up rather than or'ed, which the compiler turns
+      // into a bit test on a 64 bit mask that doesn't vectorize
+      for (byte w=0;w<n;w++) {
+        byte c = cmd[w];
+        byte zone = (c == 0x27) + (c == 0x2d) + (c == 0x34) + (c == 0x3e);
+        byte k = CMD_OTHER;
+        k = (c == 0x05) ? CMD_STATUS : k;
+        k = zone ? CMD_ZONES : k;
+        k = (c == 0xa5) ? CMD_INFO : k;
+        k = (c == 0x11) ? CMD_QUERY : k;
+        cls[w] = k;
+      }
+
+      // ----- Zones, as decodePnlData(), placed by zone group -----
+      for (byte w=0;w<n;w++) {
+        byte c = cmd[w];
+        byte shift = (c == 0x27) ? 0 : (c == 0x2d) ? 8 : (c == 0x34) ? 16 : 24;
+        unsigned long z = (unsigned long)row[6][w] << shift;
+        zones[w] = (cls[w] == CMD_ZONES) ? z : 0;
+      }
+
+      // ----- Lights, as decodePnlData() (bits 10-17, partition 1 only) -----
+      for (byte w=0;w<n;w++) {
+        byte b2 = row[2][w], b3 = row[3][w];
+        byte l = 0;
+        l |= (b2 & 0x01) ? LIGHT_READY   : 0;
+        l |= (b2 & 0x02) ? LIGHT_ARMED   : 0;
+        l |= (b2 & 0x04) ? LIGHT_MEMORY  : 0;
+        l |= (b2 & 0x08) ? LIGHT_BYPASS  : 0;
+        l |= (b2 & 0x10) ? LIGHT_TROUBLE : 0;
+        l |= (b3 & 0x80) ? LIGHT_PROGRAM : 0;
+        l |= (b2 & 0x40) ? LIGHT_FIRE    : 0;
+        lights[w] = (cmd[w] == 0x05) ? l : 0;
+      }
+
+      byte *outValid = batch.valid + base, *outCls = batch.cls + base;
+      byte *outLights = batch.lights + base;
+      unsigned long *outZones = batch.zones + base;
+      for (byte w=0;w<n;w++) outValid[w] = valid[w];
+      for (byte w=0;w<n;w++) outCls[w] = cls[w];
+      for (byte w=0;w<n;w++) outLights[w] = lights[w];
+      for (byte w=0;w<n;w++) outZones[w] = zones[w];
+    }
+  }
+
+bool DSC::wanted(byte source, byte cmd)
+  {
+    // Returns true if a callback wants the command, or no callbacks are registered
+    // for the source (all words are decoded for polling with get_xxx())
+    if (!cmd) return 0;
+    bool subscribed = false;
+    for (byte i=0;i<MAX_SUBSCRIBERS;i++) {
+      if (!subs[i].cb || subs[i].source != source) continue;
+      if (filterHas(subs[i].filter, cmd)) return 1;
+      subscribed = true;
+    }
+    return !subscribed;
+  }
+
+void DSC::dispatch(byte source, byte cmd)
+  {
+    // Calls each callback registered for the source which wants the command
+    dscEvent_t e;
+    e.source = source;
+    e.cmd = cmd;
+    if (source == DSC_PANEL) {
+      e.array = panel.array; e.len = panel.arrayLen;
+      e.msg = pMsg.getBuffer(); e.pnl = &pData; e.kpd = NULL;
+    }
+    else {
+      e.array = keypad.array; e.len = keypad.arrayLen;
+      e.msg = kMsg.getBuffer(); e.pnl = NULL; e.kpd = &kData;
+    }
+    e.first = wordFirst; e.last = wordLast;
+    for (byte i=0;i<MAX_SUBSCRIBERS;i++) {
+      if (subs[i].cb && subs[i].source == source && filterHas(subs[i].filter, cmd))
+        subs[i].cb(e);
+    }
+  }
+
+bool DSC::send_key(byte key)
+  {
+    // The key's word from the key table, padded with kOut (all 1's)
+    if (key == KEY_NONE || key >= KEY_COUNT) return 0;
+    return send_key(pgm_read_byte(&kpdKeys[key].first), 
+                    pgm_read_byte(&kpdKeys[key].code), kOut, kOut);
+  }
+
 bool DSC::send_key(byte aa, byte bb, byte cc, byte dd)
   {
-    if (!keysend.ready) return 0;         // return failure
+    if (busNum >= MAX_BUSES) return 0;    // No keybus to send on
+    if (!dscLoadAcquire(keysend.ready)) return 0;   // return failure
     if (aa == 0 && bb == 0 && cc == 0 && dd == 0) return 0;
     
-    sendBuf.clear();                      // clear the send buffer
+    wordSet(keysend.logArray, 0, sizeof(keysend.logArray));   // clear the sent bits
+    keysend.logLen = 0;
     
     keysend.array[0] = aa;
     keysend.array[1] = bb;
     keysend.array[2] = cc;
     keysend.array[3] = dd;
+    keysend.bit = 0;                      // start from the first bit
+    keysend.elem = 0;
     
-    keysend.waiting = true;               // update the keysend status
-    keysend.ready = false;
+    keysend.ready = false;                // update the keysend status
+    dscStoreRelease(keysend.waiting, true);   // after the bytes, the ISR may start now
     
     return 1;                             // return success
   }
 
+void DSC::setTrace(trace_t *trace)
+  {
+    noInterrupts();
+    bus.trace = trace;
+    interrupts();
+  }
+
+void DSC::setWordReadyHook(dscReadyHook_t hook)
+  {
+    noInterrupts();
+    bus.readyHook = hook;
+    interrupts();
+  }
+
+bool DSC::wordReady(void)
+  {
+    // True if process() has work to do
+    return dscLoadAcquire(capture.head) != capture.tail || dscLoadAcquire(capture.shortWord) || 
+           stage != STAGE_IDLE || (dscLoadAcquire(priority.flags) && priorityCb);
+  }
+
+bool DSC::waitWord(unsigned long timeout_ms)
+  {
+    unsigned long start = millis();
+    while (!wordReady()) {
+      if (timeout_ms && millis() - start >= timeout_ms) return 0;
+      sleepCpu();
+    }
+    return 1;
+  }
+
+void DSC::sleepCpu(void)
+  {
+    // Halts the CPU until the next interrupt, a clock edge or the millis() timer.
+    // Interrupts are off while checking, so a word handed off just before the sleep
+    // still wakes it (the instruction after sei and a pending interrupt during wfi
+    // are always run).
+#if defined(__AVR__)
+    set_sleep_mode(SLEEP_MODE_IDLE);
+    noInterrupts();
+    if (!wordReady()) {
+      sleep_enable();
+      interrupts();
+      sleep_cpu();
+      sleep_disable();
+    }
+    interrupts();
+#elif defined(ESP32) || defined(ESP8266)
+    delay(1);                   // Lets the RTOS idle task run (and its power saving)
+#elif defined(__arm__)
+    noInterrupts();
+    if (!wordReady()) __asm__ volatile ("wfi");
+    interrupts();
+#endif
+  }
+
+unsigned long DSC::get_edgeTime(bool last)
+  {
+    return last ? wordLast : wordFirst;
+  }
+
+unsigned int DSC::get_latency(byte stage, byte bucket)
+  {
+    if (stage > LAT_DELIVERY || bucket >= LAT_BUCKETS) return 0;
+    return latHist[stage][bucket];
+  }
+
+void DSC::clearLatency(void)
+  {
+    for (byte s=0;s<3;s++)
+      for (byte b=0;b<LAT_BUCKETS;b++) latHist[s][b] = 0;
+  }
+
+void DSC::latCount(byte stage, unsigned long us)
+  {
+    // Bucket 0 is under 1 us, bucket n under 4^n us, the last is the rest
+    byte b = 0;
+    while (us && b < LAT_BUCKETS - 1) {
+      us >>= 2;
+      b++;
+    }
+    if (latHist[stage][b] < 0xffff) latHist[stage][b]++;
+  }
+
+void DSC::setCoalesce(unsigned int window_ms, byte perSec)
+  {
+    coalesceMs = window_ms;
+    ratePerSec = perSec;
+    for (byte i=0;i<COALESCE_SLOTS;i++) slots[i].source = 0xff;
+    for (byte i=0;i<2;i++) tokens[i] = perSec, rateTime[i] = millis();
+  }
+
+unsigned long DSC::get_suppressed(byte reason)
+  {
+    if (reason > COALESCE_RATE) return 0;
+    return suppressed[reason];
+  }
+
+bool DSC::coalesce(byte source, byte cmd)
+  {
+    // Returns 1 if the word is to be output, 0 if it is suppressed
+    unsigned long now = millis();
+    
+    // The word is compared whole, bytes and length, with the last two output
+    const volatile byte *arr = (source == DSC_PANEL) ? panel.array : keypad.array;
+    byte size = (source == DSC_PANEL) ? panel.size : keypad.size;
+    byte len = (source == DSC_PANEL) ? panel.arrayLen : keypad.arrayLen;
+
+    // Find the command's slot, or take the one unused the longest
+    coalesce_t *slot = NULL;
+    coalesce_t *oldest = &slots[0];
+    for (byte i=0;i<COALESCE_SLOTS && !slot;i++) {
+      if (slots[i].source == source && slots[i].cmd == cmd) slot = &slots[i];
+      else if (slots[i].source == 0xff) oldest = &slots[i];
+      else if (oldest->source != 0xff && now - slots[i].time > now - oldest->time) 
+        oldest = &slots[i];
+    }
+
+    bool same = slot && len == slot->len && wordEq(slot->word, arr, size);
+    if (slot && now - slot->time < coalesceMs) {
+      bool button = (source == DSC_KEYPAD && (cmd == fire || cmd == aux || cmd == panic));
+      if (same && source == DSC_PANEL) {
+        suppressed[COALESCE_DUP]++;
+        return 0;
+      }
+      if (same && button) {
+        suppressed[COALESCE_KEY]++;
+        return 0;
+      }
+      if (source == DSC_PANEL && len == slot->prevLen && wordEq(slot->prev, arr, size)) {
+        suppressed[COALESCE_OSC]++;
+        return 0;
+      }
+    }
+
+    // Rate limit, the tokens build up at ratePerSec (to one second's worth).  A word
+    // which changes is always output, only the repeats are dropped when out of tokens
+    if (ratePerSec) {
+      unsigned long elapsed = now - rateTime[source];
+      if (elapsed >= 1000) {
+        tokens[source] = ratePerSec;
+        rateTime[source] = now;
+      }
+      else if (elapsed * ratePerSec >= 1000) {
+        byte add = elapsed * ratePerSec / 1000;
+        tokens[source] = (tokens[source] + add > ratePerSec) ? ratePerSec : tokens[source] + add;
+        rateTime[source] += add * 1000UL / ratePerSec;
+      }
+      if (!tokens[source] && same) {
+        suppressed[COALESCE_RATE]++;
+        return 0;
+      }
+      if (tokens[source]) tokens[source]--;
+    }
+
+    if (!slot) {
+      slot = oldest;
+      slot->source = source, slot->cmd = cmd;
+      slot->len = 0, slot->prevLen = 0;
+    }
+    if (!same) {
+      for (byte i=0;i<COALESCE_ARR_SIZE;i++) {
+        slot->prev[i] = slot->word[i];
+        slot->word[i] = (i < size) ? arr[i] : 0;
+      }
+      slot->prevLen = slot->len, slot->len = len;
+    }
+    slot->time = now;
+    return 1;
+  }
+
+void DSC::setPriorityCallback(dscPriorityCallback_t cb)
+  {
+    priorityCb = cb;
+  }
+
+byte DSC::getPriority(void)
+  {
+    // Takes the flags and the time they were raised together, the ISR may raise 
+    // another one at any edge
+    noInterrupts();
+    byte flags = dscExchange(priority.flags, (byte)0);
+    unsigned long stamp = dscLoadAcquire(priority.stamp);
+    interrupts();
+
+    if (flags) {
+      prioLatency = micros() - stamp;
+      if (prioLatency > prioLatencyMax) prioLatencyMax = prioLatency;
+    }
+    return flags;
+  }
+
+unsigned long DSC::get_priorityLatency(bool longest)
+  {
+    return longest ? prioLatencyMax : prioLatency;
+  }
+
+void DSC::setPartitions(byte count)
+  {
+    if (count < 1) count = 1;
+    if (count > MAX_PARTITIONS) count = MAX_PARTITIONS;
+    partitions = count;
+  }
+
+byte DSC::getLights(byte partition)
+  {
+    if (partition < 1 || partition > MAX_PARTITIONS) return 0;
+    return lights[partition - 1];         // return the light bits
+  }
+
+byte DSC::getLightsChanged(byte partition)
+  {
+    if (partition < 1 || partition > MAX_PARTITIONS) return 0;
+    byte changed = lightsChanged[partition - 1];
+    lightsChanged[partition - 1] = 0;     // clear the change flags
+    return changed;                       // return the changed light bits
+  }
+
+byte DSC::getState(byte partition)
+  {
+    if (partition < 1 || partition > MAX_PARTITIONS) return 0;
+    return state[partition - 1];          // return the state bits
+  }
+
+byte DSC::getStateChanged(byte partition)
+  {
+    if (partition < 1 || partition > MAX_PARTITIONS) return 0;
+    byte changed = stateChanged[partition - 1];
+    stateChanged[partition - 1] = 0;      // clear the change flags
+    return changed;                       // return the changed state bits
+  }
+
+byte DSC::getUser(byte partition)
+  {
+    if (partition < 1 || partition > MAX_PARTITIONS) return 0;
+    return user[partition - 1];
+  }
+
+unsigned int DSC::get_overflows(byte source)
+  {
+    if (source == DSC_KEYPAD) return keypad.overflows;
+    return panel.overflows;
+  }
+
+unsigned int DSC::get_dropped(void)
+  {
+    noInterrupts();                       // Two bytes on AVR, the ISR may change it
+    unsigned int n = dscLoadAcquire(capture.dropped);
+    interrupts();
+    return n;
+  }
+
 bool DSC::get_time(void)
   {
     return timeAvailable;                 // return kCmd
@@ -728,7 +1865,7 @@ bool DSC::timeout(void)
     return s;                             // return timeout status
   }
 
-unsigned int DSC::byteToInt(byte* dataArr, int offset, int dataLen, bool padding)
+unsigned int DSC::byteToInt(const volatile byte* dataArr, int offset, int dataLen, bool padding)
   {
     // Returns the value of the binary data in the byte from "offset" to "dataLen" as an int
     int byteNum = 0;                      // Int automatically rounds down
@@ -750,68 +1887,52 @@ unsigned int DSC::byteToInt(byte* dataArr, int offset, int dataLen, bool padding
       offset = offset - (byteNum * 8);
     }
     
-    // Convert the byte, and the one following, to 16 binary digits
+    // Take the byte, and the one following, as 16 bits
     //   - needs both bytes in case the data spans more than one byte
-    String bothBytes = byteToBin(dataArr[byteNum], 8) + byteToBin(dataArr[byteNum + 1], 8);
-    int iBuf = 0;
-    for(int j=0;j<dataLen;j++) {
-      iBuf <<= 1;
-      if (bothBytes[offset+j] == '1') iBuf |= 1;
-    }
-    return iBuf;
-  }
-
-/*
-const char* DSC::binToChar(String &dataStr, int offset, int endData)
-  {   
-    tempByte.clear();
-    // Returns a char array of the binary data in the String from "offset" to "endData"
-    tempByte.print(dataStr[offset]);
-    for(int j=1;j<(endData-offset);j++) {
-      tempByte.print(dataStr[offset+j]);
-    }
-    return tempByte.getBuffer();
+    unsigned int bothBytes = (dataArr[byteNum] << 8) | dataArr[byteNum + 1];
+    return (bothBytes >> (16 - offset - dataLen)) & ((1UL << dataLen) - 1);
   }
-*/
 
-const String DSC::byteToBin(byte b, byte digits)
+const char* DSC::byteToBin(byte b, byte digits)
   {
     // Returns the X bit binary representation of byte "b" with leading zeros
-    // where X is the number of binary digits up to 8
+    // where X is the number of binary digits up to 8 (more if "b" needs them)
     if (digits > 8) digits = 8;
-    int zeros = abs(digits)-String(b, BIN).length();
-    String zStr = "";
-    for (int i=0;i<zeros;i++) zStr += "0";
-    return zStr + String(b, BIN);
+    if (digits == 0) digits = 1;
+    while (digits < 8 && (b >> digits)) digits++;
+    for (byte i=0;i<digits;i++) binBuf[i] = ((b >> (digits - 1 - i)) & 1) ? '1' : '0';
+    binBuf[digits] = 0;
+    return binBuf;
   }
 
 void DSC::setCLK(int p)
   {
     // Sets the clock pin, must be called prior to begin()
-    CLK = p;
+    bus.CLK = p;
   }
 
 void DSC::setDTA_IN(int p)
   {
     // Sets the data in pin, must be called prior to begin()
-    DTA_IN = p;
+    bus.DTA_IN = p;
   }
   
 void DSC::setDTA_OUT(int p)
   {
     // Sets the data out pin, must be called prior to begin()
-    DTA_OUT = p;
+    bus.DTA_OUT = p;
   }
 void DSC::setLED(int p)
   {
     // Sets the LED pin, must be called prior to begin()
-    LED = p;
+    bus.LED = p;
   }
 
 size_t DSC::write(uint8_t character) 
   { 
     // Code to display letter when given the ASCII code for it
     // Not yet implemented
+    return 0;
   }
 
 size_t DSC::write(const char *str) 
@@ -820,6 +1941,7 @@ size_t DSC::write(const char *str)
     // remember, the last character will be null, so you can use a while(*str). 
     // You can increment str (str++) to get the next letter
     // Not yet implemented
+    return 0;
   }
   
 size_t DSC::write(const uint8_t *buffer, size_t size) 
@@ -827,9 +1949,10 @@ size_t DSC::write(const uint8_t *buffer, size_t size)
     // Code to display array of chars when given a pointer to the beginning 
     // of the array and a size -- this will not end with the null character
     // Not yet implemented
+    return 0;
   }
 
-bool DSC::wordCmp(byte *a, byte *b, byte len)
+bool DSC::wordCmp(const volatile byte *a, const volatile byte *b, byte len)
   {
     // test each element to be the same. if not, return false
     for (byte n=0;n<len;n++) if (a[n]!=b[n]) return 0;
@@ -843,15 +1966,22 @@ bool DSC::wordCmp(byte *a, byte *b, byte len)
  / global scope so they can be called by the interrupt handler
 */
 
-void wordCpy(byte *a, byte *b, byte len)
+void DSC_IRAM wordCpy(const volatile byte *a, volatile byte *b, byte len)
   {
     // copy each element in byte array a of length len to byte array b
     for (byte n=0;n<len;n++) b[n]=a[n];
   }
   
-void wordSet(byte *a, int b, byte len)
+void DSC_IRAM wordSet(volatile byte *a, int b, byte len)
   {
     // set each element in byte array a of length len to int b
     for (byte n=0;n<len;n++) a[n]=b;
   }
+
+bool wordEq(const byte *a, const volatile byte *b, byte len)
+  {
+    // compare each element in byte array a of length len with byte array b
+    for (byte n=0;n<len;n++) if (a[n] != b[n]) return false;
+    return true;
+  }
 ///////// END //////////
@@ -25,32 +25,200 @@ DSC.h (
 #include "WProgram.h"
 #endif
 
+/* A text buffer of SIZE characters, printed to like Serial.  The memory is part of
+ * the object, so nothing is allocated on the heap, text past SIZE is dropped.
+ */
+template <int SIZE>
+class dscText : public Print
+{
+  public:
+    dscText(void) { clear(); }
+    void clear(void) { len = 0; buf[0] = 0; }
+    const char* getBuffer(void) { return buf; }
+    int getSize(void) { return len; }
+
+    virtual size_t write(uint8_t c)
+      {
+        if (len >= SIZE) return 0;
+        buf[len++] = c;
+        buf[len] = 0;
+        return 1;
+      }
+    using Print::write;
+
+  private:
+    char buf[SIZE + 1];
+    int len;
+};
+
+/* Fields extracted from the panel and keypad words by the decode stage of process().
+ * The format stage builds the panel and keypad messages from these.
+ */
+typedef struct
+{
+  // ----- Status (0x05), partition 1 in [0] -----
+  byte lights[MAX_PARTITIONS];      // Keypad light bits (LIGHT_xxx in DSC_Constants.h)
+  byte exitAlarm[MAX_PARTITIONS];   // 2 = Exit Delay, 3 = Alarm (in question)
+  byte state[MAX_PARTITIONS];       // STATE_xxx bits, from the two above
+  byte partitions;                  // Number of partitions decoded from the word
+  bool powerFail;       // In question, one partition only (bit 29 is partition 2's Bypass)
+
+  // ----- Zones (0x27, 0x2d, 0x34, 0x3e) -----
+  byte zones;           // One bit per zone, lowest zone in bit 0
+
+  // ----- Info (0xa5) -----
+  byte partition;       // Partition armed or disarmed (bits 17-18), 0 if not given
+  byte arm;             // 2 = Armed, 3 = Disarmed
+  byte master;          // Master code used
+  byte user;            // User code number
+  int yy, mm, dd, HH, MM;
+}
+pnlData_t;
+
+typedef struct
+{
+  const __FlashStringHelper* btn;   // Button name, NULL if not a button
+  byte key;                         // Button (KEY_xxx), KEY_NONE if not a button
+  byte code;                        // Keypad data byte (2nd byte of the word)
+}
+kpdData_t;
+
+/* Event passed to the callbacks registered with DSC.subscribe(). The pointers are
+ * only valid for the duration of the callback.
+ */
+typedef struct
+{
+  byte source;                      // DSC_PANEL or DSC_KEYPAD
+  byte cmd;                         // Command byte of the word
+  const volatile byte* array;       // Raw word bytes
+  byte len;                         // Word length in bits
+  const char* msg;                  // Decoded message, as get_pMsg()/get_kMsg()
+  const pnlData_t* pnl;             // Decoded panel fields (NULL for keypad events)
+  const kpdData_t* kpd;             // Decoded keypad fields (NULL for panel events)
+  unsigned long first;              // micros() of the word's first clock edge
+  unsigned long last;               // micros() of the word's last clock edge
+}
+dscEvent_t;
+
+typedef void (*dscCallback_t)(const dscEvent_t &event);
+
+// Called with the PRIO_xxx flags raised, and the micros from the edge which raised
+// the first of them until the call
+typedef void (*dscPriorityCallback_t)(byte flags, unsigned long latency);
+
+typedef struct
+{
+  dscCallback_t cb;                 // NULL if the slot is free
+  byte source;                      // DSC_PANEL or DSC_KEYPAD
+  const byte* filter;               // 32 byte (256 bit) command filter, NULL for all
+}
+subscriber_t;
+
+typedef struct
+{
+  byte source;                      // DSC_PANEL or DSC_KEYPAD, 0xff if the slot is free
+  byte cmd;                         // Command byte
+  byte len;                         // Bits of the last word output, 0 if none
+  byte prevLen;                     // Bits of the one before it, 0 if none
+  byte word[COALESCE_ARR_SIZE];     // The last word output
+  byte prev[COALESCE_ARR_SIZE];     // The one before it
+  unsigned long time;               // millis() when the last word was output
+}
+coalesce_t;
+
+/* A block of captured panel words for DSC::decodeBatch(), as a structure of arrays:
+ * byte i of word w is bytes[i][w], and every array holds "count" entries.  Each
+ * step of the decode then runs along a whole row of words, which the compiler can
+ * vectorize on hosts with SIMD, and which is a plain loop on the boards.  The lights
+ * are decoded for partition 1 only, with setPartitions() above 1 the lights of the
+ * other partitions are only decoded by process().
+ */
+typedef struct
+{
+  unsigned int count;               // Words in the block
+  const byte* len;                  // Word lengths in bits
+  const byte* bytes[PNL_ARR_SIZE];  // Word bytes, laid out as the ISR builds them
+
+  // Results
+  byte* valid;                      // 1 if the checksum is valid (pnlChkValid())
+  byte* cls;                        // Command class (CMD_xxx)
+  unsigned long* zones;             // Zone words, zone n in bit n-1 (else 0)
+  byte* lights;                     // Status words, LIGHT_xxx bits of partition 1 only (else 0)
+}
+dscBatch_t;
+
 class DSC : public Print  // Initialize DSC as an extension of the print class
 {
   public:
     // Class to call to initialize the DSC Class
     // for example...  DSC dsc;
     DSC(void);
+
+    // Initializes the DSC Class on keybus number "busNum" (0 to MAX_BUSES - 1),
+    // to monitor more than one panel, for example...  DSC dsc2(1);
+    // Each keybus must be given its own pins with the set functions below.
+    // DSC(void) is keybus 0.  A keybus is used by one instance at a time.
+    DSC(byte busNum);
+
+    // Initializes the DSC Class as a decoder only, on the keybus state "state" kept
+    // by the caller (one for each instance) instead of a keybus.  There is no pin 
+    // or interrupt: the words are fed with replayWord() or injectEdge(), begin() and
+    // send_key() return false.  These aren't limited to MAX_BUSES, for a gateway
+    // decoding the words forwarded from many panels, for example...
+    //   dscBus_t state;  DSC dsc(state);
+    DSC(dscBus_t &state);
+    ~DSC(void);
+
+    // Returns false if the instance was refused its keybus, because the number was
+    // out of range or another instance has it.  It then does nothing: begin() 
+    // returns false and process() always returns -1.
+    bool valid(void);
     
     // Used to add the serial instance to the DSC Class
     int addSerial(void);
     
     // Included in the setup function of the user's sketch
     // Begins the the class, sets the pin modes, attaches the interrupt
-    void begin(void);
+    // Returns false if the instance has no keybus (see valid()), or is a decoder
+    // only instance
+    bool begin(void);
     
     // Included in the main loop of user's sketch, checks and processes 
     // the current panel and keypad words if able
-    // Returns:   0   (No 
+    // Returns:   3   Both panel and keypad words were decoded
+    //            2   Keypad word was decoded
+    //            1   Panel word was decoded
+    //            0   Neither word was decoded (duplicate or empty words)
+    //           -1   Still building word (nothing waiting to be decoded)
+    //           -2   Complete word was too short and was discarded
+    //           -3   Word partially processed, budget used up (call again)
     int process(void);
+
+    // Same as process(), but stops between pipeline stages once "budget_us"
+    // microseconds have been used, and resumes there on the next call. At least
+    // one stage is always run. A budget of 0 runs the word to completion.
+    int process(unsigned long budget_us);
     
     // Decodes the panel and keypad words, returns 0 for failure and the command
     // byte for success
     byte decodePanel(void);
     byte decodeKeypad(void);
     
-    // Ends, or de-constructs the class - NOT USED  
-    //int end();
+    // Ends reading the keybus (detaches the interrupt), the decoded state is kept
+    void end(void);
+
+    // Feeds one clock edge to the keybus as if it came from the ISR, with the new
+    // clock level "clk", data level "data", and the edge time "us" in micros (which
+    // need not be real time). Used by DSC_Sim to drive the library without a panel.
+    // Returns the data line level as seen by the panel (low while sending a key)
+    bool injectEdge(bool clk, bool data, unsigned long us);
+
+    // Loads a captured word (arrays of PNL_ARR_SIZE/KPD_ARR_SIZE bytes laid out as the
+    // ISR builds them, "pLen"/"kLen" bits long) in place of the ISR, for replaying a
+    // corpus of words or benchmarking the decode.  The last panel word is forgotten,
+    // so the word is not skipped as a duplicate.
+    // The next process() decodes it, or call decodePanel()/decodeKeypad() directly.
+    void replayWord(const byte* pArr, byte pLen, const byte* kArr, byte kLen);
     
     // Returns the panel and keypad word in formatted binary (returns NULL if failure)
     const char* get_pnlFormat(void);
@@ -63,6 +231,10 @@ class DSC : public Print  // Initialize DSC as an extension of the print class
     // Returns the panel and keypad word in raw binary (returns NULL if failure)
     const char* get_pnlRaw(void);
     const char* get_kpdRaw(void);
+
+    // Returns the bits of the last send_key() word in raw binary, as sent so far
+    // (returns NULL if none have been sent)
+    const char* get_sendRaw(void);
     
     // Returns the panel and keypad messages (returns NULL if failure)
     const char* get_pMsg(void);
@@ -72,24 +244,163 @@ class DSC : public Print  // Initialize DSC as an extension of the print class
     byte get_pCmd(void);
     byte get_kCmd(void);
     
+    // Registers a callback for panel (DSC_PANEL) or keypad (DSC_KEYPAD) words whose
+    // command byte is set in "filter", a 32 byte bitmap (bit n = command n) which
+    // must remain valid while subscribed, or NULL for all commands. While any
+    // callback is registered for a source, commands no callback wants are not
+    // decoded (get_pCmd()/get_kCmd() return 0 for them).
+    // Returns the subscription number, or -1 if there is no free slot
+    int subscribe(dscCallback_t cb, byte source, const byte* filter);
+    bool unsubscribe(int id);
+
+    // Used to build a 32 byte command filter for subscribe()
+    static void filterClear(byte* filter);
+    static void filterAdd(byte* filter, byte cmd);
+    static bool filterHas(const byte* filter, byte cmd);
+
+    // Returns bit "n" (0 = first bit sent) of a word array "len" bits long, laid out
+    // as the ISR builds it, with the panel "padding" bit in its own byte or not
+    static bool wordBit(const volatile byte* a, byte len, byte n, bool padding);
+
+    // Decodes a block of panel words at once, the checksum, command class, zones 
+    // and lights of each, with the same results as decoding them one at a time
+    // (with setResync() off, the words aren't repaired).  For bulk processing of
+    // captured words, no class state is changed.
+    static void decodeBatch(dscBatch_t &batch);
+
+#if defined(ESP32)
+    // Used instead of begin() to split the library over the two cores: the clock
+    // interrupt is attached on "captureCore", and a task on "decodeCore" runs
+    // process() as each word is handed off or a priority flag is raised (the word
+    // ready hook is taken for it).
+    // The loop() must not call process() then, and the callbacks run in that task,
+    // so they must not block it for long.  Returns false if the task couldn't be
+    // created.
+    bool beginDualCore(byte captureCore = 0, byte decodeCore = 1);
+#endif
+
+    // Sets the edge trace the ISR records each clock edge in (NULL for none), this is
+    // used by DSC_Trace
+    void setTrace(trace_t *trace);
+
+    // Sets a function for the ISR to call each time a word is handed off to the
+    // capture queue, or a priority flag is raised (NULL for none).  It runs in the
+    // interrupt, so it should only set a flag or wake a task, the word is decoded
+    // and the priority callback called by process() as usual.
+    void setWordReadyHook(dscReadyHook_t hook);
+
+    // Returns true if process() has work to do (a word waiting, or part way through
+    // the pipeline), for loops which don't want to poll process() continuously
+    bool wordReady(void);
+
+    // Sleeps (AVR idle mode, WFI on ARM, delay(1) on ESP) until process() has work
+    // to do, or "timeout_ms" has passed (0 to wait forever).  Returns wordReady().
+    // The keybus clock edges wake the CPU too, so it sleeps between edges.
+    bool waitWord(unsigned long timeout_ms = 0);
+
+    // Returns the micros() of the first or "last" clock edge of the word last 
+    // decoded, as stamped by the ISR (the edge times given to injectEdge())
+    unsigned long get_edgeTime(bool last);
+
+    // Returns the count of delivered words whose latency in "stage" (LAT_xxx) fell
+    // in "bucket" (under 4^bucket us), to see where the time goes from the last edge
+    // of a word until the sketch has it.  Counts stop at 65535, clearLatency() 
+    // starts again.  Replayed words are not counted, and injected edges are in a
+    // different time to micros() so the counts are not meaningful with DSC_Sim.
+    unsigned int get_latency(byte stage, byte bucket);
+    void clearLatency(void);
+
+    // Coalesces the decoded words before they are output (the process() result, 
+    // get_xxx() and the callbacks).  Suppressed are: the same word of a command within
+    // "window_ms" of the last one output, a word going back to the one before it
+    // within the window (oscillating, output once the window has passed), and the 
+    // second of a double sent Fire/Aux/Panic button.  Repeated words are limited to
+    // "perSec" panel and "perSec" keypad words each second (0 for no limit), a word
+    // which changes is always output.  The class state (lights, time) is still 
+    // updated.  A window of 0 turns it off (default).
+    void setCoalesce(unsigned int window_ms, byte perSec);
+
+    // Returns the number of words suppressed for "reason" (COALESCE_xxx)
+    unsigned long get_suppressed(byte reason);
+
+    // Sets the callback for the priority lane (alarm, fire, and the Fire/Aux/Panic 
+    // buttons), called from process() ahead of any queued word, NULL for none
+    void setPriorityCallback(dscPriorityCallback_t cb);
+
+    // Returns the PRIO_xxx flags raised since the last call (0 if none) and clears
+    // them, for polling instead of the callback
+    byte getPriority(void);
+
+    // Returns the last and the longest priority latency, micros from the edge which
+    // raised a flag until it was taken (not meaningful with injectEdge() times)
+    unsigned long get_priorityLatency(bool longest);
+
     // Sends a keypad key code of four data bytes
     bool send_key(byte aa, byte bb, byte cc, byte dd);
+
+    // Sends keypad key "key" (KEY_xxx), with the same bytes the key is decoded from
+    bool send_key(byte key);
     
-    // Returns whether the time is available or not (T or F)
+    // Sets the number of partitions (1 to MAX_PARTITIONS) decoded from the status
+    // word (0x05), the panel messages then include each of them
+    void setPartitions(byte count);
+
+    // Returns the keypad light bits (LIGHT_xxx) of partition 1 to MAX_PARTITIONS, 
+    // as last decoded from the status word (0x05)
+    byte getLights(byte partition = 1);
+
+    // Returns the light bits which have changed since the last call for the 
+    // partition (0 if none), and clears them
+    byte getLightsChanged(byte partition = 1);
+
+    // Returns the ready, armed, exit delay and alarm bits (STATE_xxx) of partition 1
+    // to MAX_PARTITIONS, as last decoded from the status word (0x05)
+    byte getState(byte partition = 1);
+
+    // Returns the state bits which have changed since the last call for the 
+    // partition (0 if none), and clears them
+    byte getStateChanged(byte partition = 1);
+
+    // Returns the user code which last armed or disarmed the partition, from the
+    // info word (0xa5), 0 if none has been seen
+    byte getUser(byte partition = 1);
+
+    // Returns the number of panel (DSC_PANEL) or keypad (DSC_KEYPAD) words which
+    // were longer than their word buffer (PNL_ARR_SIZE/KPD_ARR_SIZE), these are 
+    // dropped and not decoded (the keypad word with an overflowed panel word)
+    unsigned int get_overflows(byte source);
+
+    // Returns the number of words lost because the capture queue was full (process()
+    // was not called often enough to keep up with the keybus)
+    unsigned int get_dropped(void);
+
+    // Returns whether the time is available or not (T or F), true from the 0xa5 word
+    // which set it until the next word is taken by process()
     bool get_time(void);
     
     // Returns whether it's been greater than NO_DATA_TIMEOUT millis 
     // since the last processed word (Generally for DEBUG purposes)
     bool timeout(void);
     
-    // Returns 1 if there is a valid checksum, 0 if not
+    // Returns the checksum if it is valid, 0 if not (a valid checksum of 0x00 is
+    // returned as 0 too, see pnlChkValid())
     int pnlChkSum(void);
+
+    // Returns true if the checksum is valid, unlike pnlChkSum() this includes a 
+    // checksum of 0x00
+    bool pnlChkValid(void);
+
+    // Turns the repair of panel words with a bad checksum on (default) or off, and
+    // returns the number of words repaired, and those which could not be repaired
+    // and were discarded (see CHKSUM_CMDS)
+    void setResync(bool on);
+    unsigned int get_repaired(void);
+    unsigned int get_unrecoverable(void);
     
     // Conversion operation functions
-    unsigned int binToInt(String &dataStr, int offset, int dataLen);
-    //const char* binToChar(String &dataStr, int offset, int endData);  // not needed
-    const String byteToBin(byte b, byte digits);
-    unsigned int byteToInt(byte* dataArr, int offset, int dataLen, bool padding);
+    // byteToBin() returns the digits in a buffer which is reused by the next call
+    const char* byteToBin(byte b, byte digits);
+    unsigned int byteToInt(const volatile byte* dataArr, int offset, int dataLen, bool padding);
     
     // Used to set the pins to values other than the default
     void setCLK(int p);
@@ -98,13 +409,13 @@ class DSC : public Print  // Initialize DSC as an extension of the print class
     void setLED(int p);
     
     // Used to compare two word arrays of equal length (len)
-    bool wordCmp(byte *a, byte *b, byte len);
+    bool wordCmp(const volatile byte *a, const volatile byte *b, byte len);
 
     // Used to copy a byte array to another array of equal length (len)
-    // void wordCpy(byte *a, byte *b, byte len);    // Prototype global in DSC.cpp
+    // void wordCpy(const volatile byte *a, volatile byte *b, byte len);  // Prototype global in DSC.cpp
     
     // Used to reset each element of an array of length (len) to int b
-    // void wordSet(byte *a, int b, byte len);      // Prototype global in DSC.cpp
+    // void wordSet(volatile byte *a, int b, byte len);   // Prototype global in DSC.cpp
 
     // ----- Print class extension variables -----
     virtual size_t write(uint8_t);
@@ -118,6 +429,96 @@ class DSC : public Print  // Initialize DSC as an extension of the print class
     
   private:
     uint8_t intrNum;
+    bool attached;              // The interrupt is attached (begin() until end())
+    byte busNum;                // DSC_NO_BUS if refused its keybus
+
+    // ----- Keybus State (this instance's block in dscBus[]) -----
+    dscBus_t   &bus;
+    timing_t   &timing;
+    panel_t    &panel;
+    keypad_t   &keypad;
+    keysend_t  &keysend;
+    capqueue_t &capture;
+    priority_t &priority;
+
+    // ----- Message Buffers -----
+    dscText<MSG_BITS + (MAX_PARTITIONS - 1) * PART_MSG_BITS> pMsg;   // Panel message
+    dscText<MSG_BITS> kMsg;     // Keypad message
+    dscText<KSD_LOG_LEN> sendBuf;   // Sent keypad word
+    dscText<WORD_BITS> wordBuf; // get_xxxFormat/Array/Raw() text
+    char binBuf[9];             // byteToBin() digits
+
+    void init(void);
+
+    // ----- Process Pipeline -----
+    byte stage;                 // Next pipeline stage to run (STAGE_xxx)
+    byte pCmdPend, kCmdPend;    // Command bytes of the word in the pipeline
+    bool pSum;                  // Cached pnlChkValid() of the word in the pipeline
+    pnlData_t pData;            // Fields decoded from the panel word
+    kpdData_t kData;            // Fields decoded from the keypad word
+
+    // ----- Bit Resync -----
+    bool resync;                // Repair words with a bad checksum
+    unsigned int repaired;      // Words repaired
+    unsigned int unrecoverable; // Words discarded, no single alignment was valid
+    bool resyncPanel(void);
+
+    // ----- Keypad Light State, per partition -----
+    byte partitions;                      // Partitions decoded, set by setPartitions()
+    byte lights[MAX_PARTITIONS];          // Current light bits
+    byte lightsChanged[MAX_PARTITIONS];   // Bits changed since the last getLightsChanged()
+    byte state[MAX_PARTITIONS];           // Current state bits
+    byte stateChanged[MAX_PARTITIONS];    // Bits changed since the last getStateChanged()
+    byte user[MAX_PARTITIONS];            // Last user code to arm or disarm
+    void formatStatus(byte p);
+
+    // ----- Priority Lane -----
+    dscPriorityCallback_t priorityCb;
+    unsigned long prioLatency, prioLatencyMax;
+
+    // ----- Word Ready -----
+    bool ledOn;                           // Last level written to the LED
+    void sleepCpu(void);
+
+    // ----- Latency -----
+    unsigned long wordFirst, wordLast;    // Edge times of the word in the pipeline
+    unsigned long wordHandoff;            // Time it was handed off by the ISR
+    unsigned long wordLoaded;             // Time it was taken from the capture queue
+    bool wordStamped;                     // False for replayed words
+    unsigned int latHist[3][LAT_BUCKETS];
+    void latCount(byte stage, unsigned long us);
+
+    // ----- Event Coalescing -----
+    unsigned int coalesceMs;              // Window, 0 if off
+    byte ratePerSec;                      // Limit per source, 0 if none
+    coalesce_t slots[COALESCE_SLOTS];
+    byte tokens[2];                       // Words which may still be output, per source
+    unsigned long rateTime[2];            // millis() the tokens were last added
+    unsigned long suppressed[4];          // Per COALESCE_xxx reason
+    bool coalesce(byte source, byte cmd);
+
+    // ----- Event Subscriptions -----
+    subscriber_t subs[MAX_SUBSCRIBERS];
+    bool wanted(byte source, byte cmd);
+    void dispatch(byte source, byte cmd);
+
+    bool loadWord(void);
+    int runStage(void);
+
+    // Pipeline stages, split by panel and keypad word
+    byte checkPanel(void);
+    byte checkKeypad(void);
+    void decodePnlData(byte cmd);
+    void decodeKpdData(byte cmd);
+    void updatePnlState(byte cmd);
+    void formatPanel(byte cmd);
+    void formatKeypad(byte cmd);
+
+    // Panel word fields, as listed by the schema (pnlFields in DSC.cpp)
+    void setField(byte dest, byte arg, byte p, unsigned int v);
+    void keepField(byte dest, byte arg, byte p, byte stateBits);
+    unsigned int getField(byte dest, byte arg, byte p);
+    void formatFields(byte cmd, byte p);
 };
 
 #endif
@@ -15,17 +15,158 @@
 // ----- Word Size Constants -----
   /*
    * The following constants may be adjusted however the memory capability of
-   * the specific board being used must be taken into account.
+   * the specific board being used must be taken into account.  Each channel's
+   * word buffers are sized by its own constant, a word longer than its buffer is
+   * counted as an overflow and dropped, not decoded (see get_overflows()).
   */
-const byte MAX_BITS = 164;          // The length at which to overflow (max 255)
-const byte WORD_BITS = 108;         // The expected length of a word (max 255)
+const byte PNL_ARR_SIZE = 12;       // Panel word buffer in bytes (min 7, max 31)
+const byte KPD_ARR_SIZE = 12;       // Keypad word buffer in bytes (min 4, max 31)
+const byte KSD_ARR_SIZE = 4;        // Keypad send buffer in bytes (4 data bytes)
+const byte KSD_LOG_LEN = 52;        // Sent keypad bits kept (see get_sendRaw())
 const byte MSG_BITS = 80;           // The expected length of a message (max 255)
-const byte ARR_SIZE = 12;           // (max 255)   // NOT USED
+const byte PART_MSG_BITS = 76;      // Status text added by each partition after the first
+
+// Length of the formatted word text, "[Panel]  " + 9 characters per byte + " (OK)"
+const int WORD_BITS = 
+    (PNL_ARR_SIZE > KPD_ARR_SIZE ? PNL_ARR_SIZE : KPD_ARR_SIZE) * 9 + 16;
+
+// ----- Keybus Instance Constants -----
+  /*
+   * Each keybus (panel) monitored needs its own interrupt pin and about 250 bytes
+   * of RAM, so the smaller boards are limited to one.  (max 4)
+  */
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega32U4__)
+const byte MAX_BUSES = 1;           // Number of keybuses which may be monitored
+#else
+const byte MAX_BUSES = 2;           // Number of keybuses which may be monitored
+#endif
+const byte DSC_NO_BUS = 0xff;       // busNum of an instance without a keybus
+const byte DSC_DETACHED = 0xfe;     // busNum of a decoder only instance (not limited
+                                    // to MAX_BUSES, see DSC(dscBus_t &state))
 
 // ----- Word Timing Constants -----
 const int NEW_WORD_INTV = 5200;     // New word indicator interval in us (Micros)
 const int NO_DATA_TIMEOUT = 20000;  // Time to flag indicating no data (Millis)
 
+// ----- Process Pipeline Constants -----
+  /*
+   * Completed words are handed off by the ISR into a small queue and then decoded
+   * by process() in stages.  PIPE_DEPTH must be a power of 2 (max 128).
+  */
+const byte PIPE_DEPTH = 4;          // Number of captured words waiting to be decoded
+
+// ----- Dual Core Constants (ESP32, see DSC.beginDualCore()) -----
+const int DSC_DECODE_STACK = 4096;  // Stack of the decode task, the callbacks run on it
+const byte DSC_DECODE_PRIO = 2;     // Priority of the decode task, above loop()
+
+// ----- Process Pipeline Stages -----
+const byte STAGE_IDLE   = 0;        // No word loaded, waiting on the capture queue
+const byte STAGE_CHECK  = 1;        // Checksum and duplicate word checks
+const byte STAGE_DECODE = 2;        // Extract the data fields from the words
+const byte STAGE_STATE  = 3;        // Update the class state (time, status, etc.)
+const byte STAGE_FORMAT = 4;        // Format the messages and dispatch the result
+
+// ----- Latency Histogram -----
+  /*
+   * Each word is timed from its last clock edge until it is delivered, in three
+   * stages.  Bucket 0 counts latencies under 1 us and bucket n those under 4^n us,
+   * the last bucket counts the rest (65 ms and over).
+  */
+const byte LAT_HANDOFF  = 0;        // Last edge until handed off (the new word gap)
+const byte LAT_QUEUE    = 1;        // Handed off until taken from the capture queue
+const byte LAT_DELIVERY = 2;        // Taken until delivered (decoded and dispatched)
+const byte LAT_BUCKETS  = 10;       // Buckets per stage
+
+// ----- Keypad Light Bits (0x05 Status) -----
+const byte LIGHT_READY   = 0x01;    // Ready
+const byte LIGHT_ARMED   = 0x02;    // Armed
+const byte LIGHT_MEMORY  = 0x04;    // Memory
+const byte LIGHT_BYPASS  = 0x08;    // Bypass
+const byte LIGHT_TROUBLE = 0x10;    // Trouble (Error)
+const byte LIGHT_PROGRAM = 0x20;    // Program
+const byte LIGHT_FIRE    = 0x40;    // Fire
+
+// ----- Partition State Bits (0x05 Status) -----
+const byte STATE_READY      = 0x01; // Ready light
+const byte STATE_ARMED      = 0x02; // Armed light
+const byte STATE_EXIT_DELAY = 0x04; // Exit delay (in question)
+const byte STATE_ALARM      = 0x08; // Alarm (in question)
+
+// ----- Priority Lane Flags -----
+  /*
+   * Raised by the ISR as soon as the bits have been clocked in, before the word ends.
+   * The panel conditions are raised when they start, the keypad buttons each time
+   * they are seen (the keypad sends them twice).  The panel conditions are those of
+   * partition 1.
+  */
+const byte PRIO_ALARM     = 0x01;   // Alarm, status word (0x05) bits 21-22 == 3
+const byte PRIO_FIRE      = 0x02;   // Fire light, status word (0x05) bit 10
+const byte PRIO_KEY_FIRE  = 0x04;   // Keypad Fire button
+const byte PRIO_KEY_AUX   = 0x08;   // Keypad Aux button
+const byte PRIO_KEY_PANIC = 0x10;   // Keypad Panic button
+
+// ----- Partition Constants -----
+  /*
+   * The status word (0x05) has a lights byte and a status byte for each partition,
+   * partition 2 is 16 bits after partition 1.  Only the partitions set with
+   * DSC.setPartitions() are decoded (1 by default).
+  */
+const byte MAX_PARTITIONS = 2;      // Partitions decoded from the status word
+const byte PART_BITS = 16;          // Bits from one partition to the next
+
+// ----- Panel Field Schema -----
+  /*
+   * Where the decode stage puts each field of the panel word schema (pnlFields in 
+   * DSC.cpp), the pnlData_t member.
+  */
+const byte FLD_LIGHT      = 1;      // Light bit "arg" (LIGHT_xxx) of lights[], per partition
+const byte FLD_EXIT_ALARM = 2;      // exitAlarm[], per partition
+const byte FLD_POWER_FAIL = 3;      // powerFail
+const byte FLD_ZONES      = 4;      // zones
+const byte FLD_YEAR       = 5;      // yy, a digit, "arg" is its weight (10 or 1)
+const byte FLD_MONTH      = 6;      // mm
+const byte FLD_DAY        = 7;      // dd
+const byte FLD_HOUR       = 8;      // HH
+const byte FLD_MINUTE     = 9;      // MM
+const byte FLD_PARTITION  = 10;     // partition
+const byte FLD_ARM        = 11;     // arm
+const byte FLD_MASTER     = 12;     // master
+const byte FLD_USER       = 13;     // user, "arg" is taken off the code when armed
+
+// Which partitions a field of the schema is decoded for, its "part"
+const byte PART_ONCE   = 0;         // Once, not a partition's field
+const byte PART_EACH   = 1;         // Each partition, PART_BITS apart
+const byte PART_SINGLE = 2;         // Once, only if one partition is decoded (the bits
+                                    // are a later partition's field otherwise)
+
+// ----- Bit Resync -----
+// Panel commands which end in a checksum byte.  A word of one of these with a bad
+// checksum is repaired if a single missed or extra clock edge explains it, and is
+// discarded if not, as every field after the bad bit would be shifted.
+const byte CHKSUM_CMDS[] = { 0x27, 0x2d, 0x34, 0x3e, 0xa5 };
+
+// ----- Batch Decode -----
+const byte BATCH_CHUNK = 16;        // Words decoded side by side (16 bytes, one SSE register)
+const byte CMD_OTHER  = 0;          // Command classes, any other command
+const byte CMD_STATUS = 1;          // Status (0x05)
+const byte CMD_ZONES  = 2;          // Zones (0x27, 0x2d, 0x34, 0x3e)
+const byte CMD_INFO   = 3;          // Info, time and arm/disarm (0xa5)
+const byte CMD_QUERY  = 4;          // Keypad query (0x11)
+
+// ----- Event Coalescing -----
+const byte COALESCE_SLOTS = 8;      // Commands remembered for coalescing
+const byte COALESCE_ARR_SIZE =      // Bytes kept of each word remembered (two per slot)
+    PNL_ARR_SIZE > KPD_ARR_SIZE ? PNL_ARR_SIZE : KPD_ARR_SIZE;
+const byte COALESCE_DUP  = 0;       // Suppressed, same as the last one output
+const byte COALESCE_OSC  = 1;       // Suppressed, back to the one before (oscillating)
+const byte COALESCE_KEY  = 2;       // Suppressed, Fire/Aux/Panic button sent twice
+const byte COALESCE_RATE = 3;       // Suppressed, over the rate limit
+
+// ----- Event Subscription Constants -----
+const byte MAX_SUBSCRIBERS = 4;     // Number of callbacks which may be registered
+const byte DSC_PANEL  = 0;          // Event source, panel word
+const byte DSC_KEYPAD = 1;          // Event source, keypad word
+
 // ------ HEX LOOK-UP ARRAY ------
 const char hex[] = "0123456789abcdef";  // HEX alphanumerics look-up array
 
@@ -59,4 +200,32 @@ const byte fire   = 0xbb;   // 10111011 (dec: 187)
 const byte aux    = 0xdd;   // 11011101 (dec: 221) 
 const byte panic  = 0xee;   // 11101110 (dec: 238) 
 
+// ----- KEYPAD KEYS -----
+// Index of each key in the keypad key table (kpdKeys in DSC.cpp), which holds the
+// key's bytes on the wire for both decoding and send_key(key)
+const byte KEY_NONE  = 0;
+const byte KEY_0     = 1;
+const byte KEY_1     = 2;
+const byte KEY_2     = 3;
+const byte KEY_3     = 4;
+const byte KEY_4     = 5;
+const byte KEY_5     = 6;
+const byte KEY_6     = 7;
+const byte KEY_7     = 8;
+const byte KEY_8     = 9;
+const byte KEY_9     = 10;
+const byte KEY_STAR  = 11;
+const byte KEY_POUND = 12;
+const byte KEY_STAY  = 13;
+const byte KEY_AWAY  = 14;
+const byte KEY_CHIME = 15;
+const byte KEY_RESET = 16;
+const byte KEY_EXIT  = 17;
+const byte KEY_LEFT  = 18;
+const byte KEY_RIGHT = 19;
+const byte KEY_FIRE  = 20;  // Sent in the 1st byte, from here on
+const byte KEY_AUX   = 21;
+const byte KEY_PANIC = 22;
+const byte KEY_COUNT = 23;
+
 #endif
@@ -5,6 +5,8 @@
  * It contains definition of global items which are used by the DSC class.
  * They have to be declared global in scope because they are accessed by
  * the ISR and you cannot pass parameters nor objects to an ISR routine.
+ * Each keybus has its own dscBus_t block, and its own ISR which is compiled
+ * with the address of that block (see clkCalled_Handler<N>() in DSC.cpp).
  * 
  * In general, applications would not include this file. 
  */
@@ -36,12 +38,6 @@
 #endif
  */
 
-// ----- Input/Output Pins -----
-extern byte CLK;         // Keybus Yellow (Clock Line)
-extern byte DTA_IN;      // Keybus Green (Data Line via V divider)
-extern byte DTA_OUT;     // Keybus Green Output (Data Line through driver)
-extern byte LED;         // LED pin on the arduino
-
 /*
  * OLD STUFF - In case I need it
  * Receiver states. This previously was enum but changed it to uint8_t
@@ -55,6 +51,92 @@ extern byte LED;         // LED pin on the arduino
 typedef uint8_t  currentState_t;
 */
 
+/* Memory ordering between the ISR and process()
+ *
+ * On a single core the ISR runs between two instructions of process(), so plain 
+ * volatile reads and writes are enough, and so are noInterrupts() sections.  When the
+ * ISR runs on another core (DSC_SMP, the ESP32 dual core mode, or a host build with
+ * the ISR and process() on two threads) they are not:
+ *   - the capture queue and trace indexes are published with a release store, after
+ *     the slot has been written, and read with an acquire load before the slot is
+ *     read.  The slot is then freed with a release store once it has been copied.
+ *   - the priority flags are raised with an atomic OR and taken with an atomic
+ *     exchange, as noInterrupts() only holds off this core's interrupts.  The time
+ *     of the first flag is stored and loaded atomically, the ISR may store it again
+ *     as soon as the flags are taken.
+ *   - the short word flag is taken with an atomic exchange, and the dropped count
+ *     is stored and loaded atomically.
+ *   - keysend.waiting is set with a release store after the bytes to send, and
+ *     keysend.ready with one once they have been sent.
+ * The functions below are those operations, and compile to plain accesses without
+ * DSC_SMP.
+ */
+
+#ifndef DSC_SMP
+#if defined(ESP32)
+#define DSC_SMP 1
+#else
+#define DSC_SMP 0
+#endif
+#endif
+
+template <typename T>
+inline T dscLoadAcquire(volatile T &x) __attribute__((always_inline));
+template <typename T>
+inline T dscLoadAcquire(volatile T &x)
+  {
+#if DSC_SMP
+    return __atomic_load_n(&x, __ATOMIC_ACQUIRE);
+#else
+    return x;
+#endif
+  }
+
+template <typename T>
+inline void dscStoreRelease(volatile T &x, T v) __attribute__((always_inline));
+template <typename T>
+inline void dscStoreRelease(volatile T &x, T v)
+  {
+#if DSC_SMP
+    __atomic_store_n(&x, v, __ATOMIC_RELEASE);
+#else
+    x = v;
+#endif
+  }
+
+template <typename T>
+inline void dscFetchOr(volatile T &x, T v) __attribute__((always_inline));
+template <typename T>
+inline void dscFetchOr(volatile T &x, T v)
+  {
+#if DSC_SMP
+    __atomic_fetch_or(&x, v, __ATOMIC_RELEASE);
+#else
+    x |= v;
+#endif
+  }
+
+template <typename T>
+inline T dscExchange(volatile T &x, T v) __attribute__((always_inline));
+template <typename T>
+inline T dscExchange(volatile T &x, T v)
+  {
+#if DSC_SMP
+    return __atomic_exchange_n(&x, v, __ATOMIC_ACQ_REL);
+#else
+    T old = x;
+    x = v;
+    return old;
+#endif
+  }
+
+// Functions called by the ISR are placed in RAM where the board needs it
+#if defined(ESP32) || defined(ESP8266)
+#define DSC_IRAM IRAM_ATTR
+#else
+#define DSC_IRAM
+#endif
+
 /* The structure contains information used by the ISR routine. Because we cannot
  * pass parameters to an ISR, vars must be global. Values which can be changed by
  * the ISR but are accessed outside the ISR must be volatile (for the most part)
@@ -72,15 +154,22 @@ typedef struct
   volatile unsigned long lastChange;      
   volatile unsigned long lastRise;      // NOT USED
   volatile unsigned long lastFall;      // NOT USED
+  volatile unsigned long wordStart;     // First clock edge of the word being built
   
   // ----- Keybus Bit/Byte Counter -----
   volatile byte bitCount;      
   } 
 timing_t;
-extern  timing_t timing;                //declared in DSC.cpp
 
-typedef struct 
+/* The word buffers are sized per channel by the template parameter SIZE (bytes),
+ * see PNL_ARR_SIZE, KPD_ARR_SIZE and KSD_ARR_SIZE in DSC_Constants.h
+ */
+
+template <byte SIZE>
+struct keybus_t
 {  
+  static const byte size = SIZE;
+
   // ----- Keybus Word Command Var -----
   byte cmd;
   
@@ -89,21 +178,27 @@ typedef struct
   volatile byte elem;                   // Using "elem" as element instead of "byte"
   
   // ----- Keybus Byte Arrays -----
-  volatile byte newArray[ARR_SIZE];
-  volatile byte array[ARR_SIZE];
-  volatile byte oldArray[ARR_SIZE]; 
+  volatile byte newArray[SIZE];
+  volatile byte array[SIZE];
+  volatile byte oldArray[SIZE]; 
   
   // ----- Keybus Byte Lengths -----
   volatile byte newArrayLen;
   volatile byte arrayLen;               //oldLen;
-} 
-keybus_t;
 
-extern  keybus_t panel;                 //declared in DSC.cpp
-extern  keybus_t keypad;                //declared in DSC.cpp
+  // ----- Buffer Overflow -----
+  volatile bool truncated;              // Word being built has overflowed
+  volatile unsigned int overflows;      // Count of words which overflowed
+};
 
-typedef struct 
+typedef keybus_t<PNL_ARR_SIZE> panel_t;
+typedef keybus_t<KPD_ARR_SIZE> keypad_t;
+
+template <byte SIZE>
+struct keysendBuf_t
 {  
+  static const byte size = SIZE;
+
   // ----- Send wait/readiness status -----
   volatile bool waiting;
   volatile bool ready;
@@ -114,13 +209,117 @@ typedef struct
   volatile byte elem;                   // Using "elem" as element instead of "byte"
   
   // ----- Keybus Byte Arrays -----
-  volatile byte array[ARR_SIZE];
+  volatile byte array[SIZE];
   
   // ----- Keybus Byte Lengths -----
   volatile byte arrayLen;               
-} 
-keysend_t;
 
-extern  keysend_t keysend;              //declared in DSC.cpp
+  // ----- Bits sent, one bit each as on the data line (see DSC.get_sendRaw()) -----
+  volatile byte logArray[(KSD_LOG_LEN + 7) / 8];
+  volatile byte logLen;
+};
+
+typedef keysendBuf_t<KSD_ARR_SIZE> keysend_t;
+
+/* The capture queue is filled by the ISR (the capture hand-off stage) at the start of
+ * each new word, and emptied by DSC.process().  The ISR is the only writer of "head"
+ * and process() is the only writer of "tail", so no locking is required (see the 
+ * memory ordering above when they are on two cores).
+ */
+
+typedef struct
+{
+  // ----- Captured Panel and Keypad Words -----
+  volatile byte pArray[PNL_ARR_SIZE];
+  volatile byte pLen;
+  volatile byte kArray[KPD_ARR_SIZE];
+  volatile byte kLen;
+
+  // ----- Edge Times (micros) -----
+  volatile unsigned long first;         // First clock edge of the word
+  volatile unsigned long last;          // Last clock edge of the word
+  volatile unsigned long handoff;       // Edge which handed it off (next word start)
+}
+capture_t;
+
+typedef struct
+{
+  capture_t word[PIPE_DEPTH];
+
+  // ----- Queue Indexes (wrap at 256, slot is index % PIPE_DEPTH) -----
+  volatile byte head;                   // Written by the ISR
+  volatile byte tail;                   // Written by process()
+
+  // ----- Capture Status -----
+  volatile unsigned int dropped;        // Words lost because the queue was full
+  volatile bool shortWord;              // A word too short to decode was discarded
+}
+capqueue_t;
+
+/* The priority lane, flags raised by the ISR (PRIO_xxx) ahead of the capture queue,
+ * and taken by DSC.process() before any queued word.
+ */
+
+typedef struct
+{
+  volatile byte flags;                  // Raised and not yet taken
+  volatile byte level;                  // Panel conditions seen in the last status word
+  volatile unsigned long stamp;         // Time of the edge which raised the first flag
+}
+priority_t;
+
+/* The edge trace, each clock edge as the ISR saw it, written by the ISR and read by
+ * DSC_Trace.  The buffer is the caller's and "size" is a power of 2.
+ */
+
+const byte TRACE_CLK     = 0x01;        // Clock line level
+const byte TRACE_DATA    = 0x02;        // Data line level (as seen by the panel)
+const byte TRACE_KEYSEND = 0x04;        // Data line pulled low to send a keypad bit
+
+typedef struct
+{
+  unsigned long us;                     // micros() of the edge
+  byte lines;                           // TRACE_xxx bits
+}
+traceEdge_t;
+
+typedef struct
+{
+  traceEdge_t *buf;
+  unsigned int size;
+  volatile unsigned int head;           // Written by the ISR
+  volatile unsigned int tail;           // Written by the reader
+  volatile unsigned int dropped;        // Edges lost because the buffer was full
+}
+trace_t;
+
+/* Called by the ISR each time a word is handed off to the capture queue.
+ */
+
+typedef void (*dscReadyHook_t)(void);
+
+/* All of the ISR state for one keybus.
+ */
+
+typedef struct
+{
+  // ----- Input/Output Pins -----
+  byte CLK;                             // Keybus Yellow (Clock Line)
+  byte DTA_IN;                          // Keybus Green (Data Line via V divider)
+  byte DTA_OUT;                         // Keybus Green Output (Data Line through driver)
+  byte LED;                             // LED pin on the arduino
+
+  timing_t   timing;
+  panel_t    panel;
+  keypad_t   keypad;
+  keysend_t  keysend;
+  capqueue_t capture;
+  priority_t priority;
+  dscReadyHook_t readyHook;             // NULL for none
+  trace_t *trace;                       // NULL for none
+}
+dscBus_t;
+
+extern  dscBus_t dscBus[MAX_BUSES];     //declared in DSC.cpp
 
 #endif
@@ -0,0 +1,302 @@
+#include "Arduino.h"
+#include "DSC_Sim.h"
+
+/*
+ * The word rotation sent by the virtual panel when nothing else is waiting.
+ * The panel sends its status word (0x05) between each of the others.
+ */
+const byte simRotation[] = { 0x05, 0x27, 0x05, 0x2d, 0x05, 0x34, 0x05, 0x3e, 0x05, 0x11 };
+const byte SIM_ROTATION_LEN = sizeof(simRotation);
+const unsigned int SIM_TIME_MS = 4000;    // Interval of the 0xa5 time words
+
+DSC_Sim::DSC_Sim(DSC &dsc)
+  : dsc(dsc)
+  {
+    scenario = NULL;
+    repeat = false, ended = true;
+    speed = 0;
+    yy = 26, mm = 1, dd = 1, HH = 0, MM = 0;
+  }
+
+void DSC_Sim::begin(const simStep_t *scenario, bool repeat)
+  {
+    dsc.end();                    // The keybus edges come from here, not the pins
+
+    this->scenario = scenario;
+    this->repeat = repeat;
+    next = 0, ended = (scenario == NULL);
+    passes = 0;
+
+    us = 0, passMs = 0, partUs = 0, simMs = 0, clockMs = 0;
+    lastReal = millis(), credit = 0;
+
+    zones = 0;
+    armed = false, alarm = false, fireOn = false;
+    lastTime = 0, rotation = 0;
+    infoArm = 0, infoUser = 0;
+    key = 0, keyRepeat = 0;
+    firstSent = false;
+
+    sentCount = 0, pulled = false;
+    for (byte i=0;i<KSD_ARR_SIZE;i++) sent[i] = 0, level[i] = 0;
+  }
+
+void DSC_Sim::setSpeed(unsigned int speed)
+  {
+    this->speed = speed;
+  }
+
+void DSC_Sim::setTime(byte yy, byte mm, byte dd, byte HH, byte MM)
+  {
+    this->yy = yy % 100, this->mm = mm, this->dd = dd;
+    this->HH = HH, this->MM = MM;
+  }
+
+bool DSC_Sim::step(void)
+  {
+    if (ended) return 0;
+
+    // The first edge of a word ends the gap, it is normally sent with the word before
+    if (!firstSent) {
+      buildWord();
+      keypadEdge(0, SIM_GAP_US);
+      firstSent = true;
+    }
+
+    // Send the rest of the word, keypad data on the falling edges and panel data
+    // on the rising edges
+    for (byte n=0;n<pBits;n++) {
+      if (n) keypadEdge(n, SIM_BIT_US / 2);
+      edge(1, panelBit(n), SIM_BIT_US / 2);
+    }
+
+    // Save the key if the DSC instance sent one during this word
+    if (pulled) {
+      for (byte i=0;i<KSD_ARR_SIZE;i++) sent[i] = level[i];
+      sentCount++;
+    }
+
+    // Start the next word, its first edge makes the ISR hand off this one
+    runScenario();
+    buildWord();
+    keypadEdge(0, SIM_GAP_US);
+    return !ended;
+  }
+
+bool DSC_Sim::update(void)
+  {
+    if (ended) return 0;
+
+    // Build up credit in virtual millis at the speed set, limited to one second
+    unsigned long now = millis();
+    if (speed) {
+      credit += (now - lastReal) * speed;
+      if (credit > 1000UL * speed) credit = 1000UL * speed;
+    }
+    lastReal = now;
+    if (speed && credit < (unsigned long)pBits * SIM_BIT_US / 1000) return 0;
+
+    unsigned long before = simMs;
+    step();
+    if (speed) credit -= (credit < simMs - before) ? credit : simMs - before;
+    return 1;
+  }
+
+unsigned long DSC_Sim::getTime(void)
+  {
+    return passMs;
+  }
+
+unsigned long DSC_Sim::getPasses(void)
+  {
+    return passes;
+  }
+
+unsigned int DSC_Sim::getSent(byte *buf)
+  {
+    if (buf) for (byte i=0;i<KSD_ARR_SIZE;i++) buf[i] = sent[i];
+    return sentCount;
+  }
+
+void DSC_Sim::runScenario(void)
+  {
+    // Apply each scenario step which is now due
+    while (scenario && scenario[next].ms <= passMs) {
+      byte arg = scenario[next].arg;
+      switch (scenario[next].event) {
+        case SIM_ZONE_OPEN:
+          if (arg >= 1 && arg <= 32) zones |= (1UL << (arg - 1));
+          break;
+        case SIM_ZONE_CLOSE:
+          if (arg >= 1 && arg <= 32) zones &= ~(1UL << (arg - 1));
+          break;
+        case SIM_ARM:
+          armed = true;
+          infoArm = 0x02, infoUser = arg;
+          break;
+        case SIM_DISARM:
+          armed = false, alarm = false;
+          infoArm = 0x03, infoUser = arg;
+          break;
+        case SIM_KEY:
+          // Fire, Aux and Panic are sent twice, with a panel word in between
+          key = arg;
+          keyRepeat = (arg == fire || arg == aux || arg == panic) ? 2 : 1;
+          break;
+        case SIM_ALARM:
+          alarm = arg;
+          break;
+        case SIM_FIRE:
+          fireOn = arg;
+          break;
+        case SIM_END:
+          if (repeat) {
+            passes++;               // Start the scenario over
+            passMs = 0, next = 0, lastTime = 0;
+          }
+          else ended = true;
+          return;
+      }
+      next++;
+    }
+  }
+
+void DSC_Sim::buildWord(void)
+  {
+    byte data[8];
+    byte idle[] = { 0xff };
+
+    pulled = false;
+    setKeypad(idle, 1);
+
+    // ----- Keep the clock, a minute of virtual time at a time -----
+    while (simMs - clockMs >= 60000UL) {
+      clockMs += 60000UL;
+      if (++MM > 59) { MM = 0; if (++HH > 23) { HH = 0; if (++dd > 28) { dd = 1; if (++mm > 12) mm = 1; } } }
+    }
+
+    // ----- 0xa5 Info, arm/disarm or the time -----
+    if (passMs < lastTime) lastTime = 0;
+    if (infoArm || passMs - lastTime >= SIM_TIME_MS) {
+      // Encoded to match DSC.decodePnlData()
+      byte raw = 0;
+      if (infoArm) {
+        byte u = (infoUser > 39) ? infoUser - 5 : infoUser;   // System codes 40-42
+        raw = (u - 1) & 0x3f;
+        if (infoArm == 0x02) raw = (raw + 0x19) & 0x3f;
+      }
+      data[0] = ((yy / 10) << 4) | (yy % 10);
+      data[1] = (mm << 2) | (dd >> 3);
+      data[2] = ((dd & 0x07) << 5) | HH;
+      data[3] = MM << 2;
+      data[4] = (infoArm << 6) | raw;
+      setPanel(0xa5, data, 5, true);
+      if (!infoArm) lastTime = passMs;
+      infoArm = 0;
+      return;
+    }
+
+    byte cmd = simRotation[rotation];
+    if (++rotation >= SIM_ROTATION_LEN) rotation = 0;
+
+    // ----- 0x05 Status, with any keypad button waiting -----
+    if (cmd == 0x05) {
+      data[0] = 0;
+      if (!zones && !armed) data[0] |= LIGHT_READY;
+      if (armed)            data[0] |= LIGHT_ARMED;
+      if (fireOn)           data[0] |= LIGHT_FIRE;
+      data[1] = alarm ? 0x0c : 0x00;          // Bits 21-22, 3 = Alarm
+      data[2] = 0x00;
+      data[3] = 0x00;
+      setPanel(0x05, data, 4, false);
+
+      if (keyRepeat) {
+        byte kData[] = { kOut, key };
+        if (key == fire || key == aux || key == panic) {
+          kData[0] = key;
+          kData[1] = 0xff;
+        }
+        setKeypad(kData, 2);
+        keyRepeat--;
+      }
+      return;
+    }
+
+    // ----- 0x11 Keypad Query, with a keypad response -----
+    if (cmd == 0x11) {
+      byte kData[] = { kOut, kOut, 0x7f };
+      data[0] = 0xaa, data[1] = 0xaa, data[2] = 0x00;
+      setPanel(0x11, data, 3, false);
+      setKeypad(kData, 3);
+      return;
+    }
+
+    // ----- Zone Words, 8 zones in each -----
+    byte group = 0;
+    if (cmd == 0x2d) group = 1;
+    if (cmd == 0x34) group = 2;
+    if (cmd == 0x3e) group = 3;
+    data[0] = 0, data[1] = 0, data[2] = 0, data[3] = 0;
+    data[4] = (zones >> (group * 8)) & 0xff;
+    setPanel(cmd, data, 5, true);
+  }
+
+void DSC_Sim::setPanel(byte cmd, const byte *data, byte len, bool chkSum)
+  {
+    // Lays the word out as the ISR builds it, the command, one padding bit, the data
+    // and the checksum (sum of all the bytes, modulo 256) if used
+    byte sum = cmd;
+    byte n = 2;
+    pWord[0] = cmd;
+    pWord[1] = 0;
+    for (byte i=0;i<len && n<PNL_ARR_SIZE;i++) {
+      pWord[n++] = data[i];
+      sum += data[i];
+    }
+    if (chkSum && n < PNL_ARR_SIZE) pWord[n++] = sum;
+    pBits = 9 + (n - 2) * 8;
+  }
+
+void DSC_Sim::setKeypad(const byte *data, byte len)
+  {
+    for (byte i=0;i<KPD_ARR_SIZE;i++) kWord[i] = (i < len) ? data[i] : 0xff;
+  }
+
+bool DSC_Sim::panelBit(byte n)
+  {
+    if (n < 8) return (pWord[0] >> (7 - n)) & 1;
+    if (n == 8) return pWord[1] & 1;
+    n -= 9;
+    return (pWord[2 + n / 8] >> (7 - n % 8)) & 1;
+  }
+
+bool DSC_Sim::keypadBit(byte n)
+  {
+    if (n / 8 >= KPD_ARR_SIZE) return 1;      // Idle keypad data line is high
+    return (kWord[n / 8] >> (7 - n % 8)) & 1;
+  }
+
+void DSC_Sim::keypadEdge(byte n, unsigned int dt)
+  {
+    // Sends a falling edge with keypad bit "n", and keeps the level seen by the
+    // panel to catch keys sent by the DSC instance
+    bool data = keypadBit(n);
+    bool line = edge(0, data, dt);
+    if (data && !line) pulled = true;
+    if (n / 8 < KSD_ARR_SIZE) {
+      if (n % 8 == 0) level[n / 8] = 0;
+      level[n / 8] = (level[n / 8] << 1) | line;
+    }
+  }
+
+bool DSC_Sim::edge(bool clk, bool data, unsigned int dt)
+  {
+    // Advances the virtual time and feeds the edge to the DSC instance
+    us += dt;
+    partUs += dt;
+    while (partUs >= 1000) {
+      partUs -= 1000;
+      passMs++, simMs++;
+    }
+    return dsc.injectEdge(clk, data, us);
+  }
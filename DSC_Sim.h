@@ -0,0 +1,129 @@
+/* DSC_Sim.h
+ * Part of DSC Library
+ * See COPYRIGHT.txt and LICENSE.txt for more information.
+ *
+ * A virtual DSC panel which generates keybus traffic (the 0x05/0x27/0x2d/0x34/0x3e
+ * rotation, 0x11 keypad queries, 0xa5 time and arm/disarm words, and keypad button
+ * words) from a scenario script, and feeds the clock and data edges into a DSC
+ * instance through DSC.injectEdge().  Time on the keybus is virtual, so traffic can
+ * be generated in real time or many times faster for soak testing.
+ *
+ * For example...  zone 3 opens at 10 s, and user 5 arms at 60 s
+ *
+ *   const simStep_t scenario[] = {
+ *     { 10000, SIM_ZONE_OPEN, 3 },
+ *     { 60000, SIM_ARM, 5 },
+ *     { 70000, SIM_END, 0 } };
+ */
+
+#ifndef DSC_Sim_h
+#define DSC_Sim_h
+#include "DSC.h"
+
+// ----- Scenario Events -----
+const byte SIM_END        = 0;      // End of the scenario (time it ends)
+const byte SIM_ZONE_OPEN  = 1;      // Zone "arg" (1-32) opens
+const byte SIM_ZONE_CLOSE = 2;      // Zone "arg" (1-32) closes
+const byte SIM_ARM        = 3;      // User "arg" arms the panel
+const byte SIM_DISARM     = 4;      // User "arg" disarms the panel
+const byte SIM_KEY        = 5;      // Keypad button "arg" (2nd byte code, or fire/aux/panic)
+const byte SIM_ALARM      = 6;      // Alarm on (arg 1) or off (arg 0)
+const byte SIM_FIRE       = 7;      // Fire light on (arg 1) or off (arg 0)
+
+// ----- Keybus Timing (virtual micros) -----
+const unsigned int SIM_BIT_US = 1000;     // Clock period of one bit
+const unsigned int SIM_GAP_US = 15000;    // New word marker, clock held high
+
+typedef struct
+{
+  unsigned long ms;                 // Time from the start of the scenario (millis)
+  byte event;                       // SIM_xxx
+  byte arg;                         // Zone, user, key or on/off
+}
+simStep_t;
+
+class DSC_Sim
+{
+  public:
+    // Attaches the virtual panel to a DSC instance
+    DSC_Sim(DSC &dsc);
+
+    // Detaches the DSC instance from its pin (if begun), and starts the scenario
+    // (terminated by SIM_END), which is run over and over if "repeat" is true
+    void begin(const simStep_t *scenario, bool repeat);
+
+    // Sets how fast update() runs the virtual time, 1 = real time, 1000 = 1000x,
+    // 0 = as fast as possible (default)
+    void setSpeed(unsigned int speed);
+
+    // Sets the date and time sent in the 0xa5 words (year 0-99)
+    void setTime(byte yy, byte mm, byte dd, byte HH, byte MM);
+
+    // Sends the next word, returns false when the scenario has ended (not repeating)
+    // The word before it is handed off by the ISR and can be processed after this
+    bool step(void);
+
+    // Sends the next word if it is due at the speed set, returns true if sent
+    bool update(void);
+
+    // Returns the virtual time in the current pass of the scenario (millis), and
+    // the number of completed passes
+    unsigned long getTime(void);
+    unsigned long getPasses(void);
+
+    // Returns the number of keys sent by the DSC instance (DSC.send_key()) seen on the
+    // keybus, and copies the last one's 4 bytes into "buf" if not NULL
+    unsigned int getSent(byte *buf);
+
+  private:
+    DSC &dsc;
+    const simStep_t *scenario;
+    bool repeat;
+    byte next;                      // Next scenario step
+    bool ended;
+    unsigned int speed;
+    unsigned long passes;
+
+    // ----- Virtual Time -----
+    unsigned long us;               // Keybus time (micros, wraps)
+    unsigned long passMs;           // Time in the current pass (millis)
+    unsigned long partUs;           // Micros not yet counted in passMs
+    unsigned long simMs;            // Total virtual millis
+    unsigned long clockMs;          // simMs when the clock minute last changed
+    unsigned long lastReal;         // millis() at the last update()
+    unsigned long credit;           // Virtual millis update() may still run
+
+    // ----- Panel State -----
+    unsigned long zones;            // Open zones, zone 1 in bit 0
+    bool armed, alarm, fireOn;
+    byte yy, mm, dd, HH, MM;
+    unsigned long lastTime;         // passMs when the last 0xa5 time was sent
+    byte rotation;                  // Position in the word rotation
+
+    // ----- Pending Words -----
+    byte infoArm, infoUser;         // 0xa5 arm/disarm word waiting to be sent
+    byte key, keyRepeat;            // Keypad button waiting to be sent
+
+    // ----- Word Being Sent -----
+    byte pWord[PNL_ARR_SIZE];       // Panel bytes (command, padding bit, data)
+    byte pBits;                     // Panel word length
+    byte kWord[KPD_ARR_SIZE];       // Keypad bytes
+    bool firstSent;                 // The first edge has been sent (it ends the gap)
+
+    // ----- Keys Sent by the DSC Instance -----
+    byte level[KSD_ARR_SIZE];       // Keypad data line as seen by the panel
+    bool pulled;                    // The DSC instance pulled the line low
+    byte sent[KSD_ARR_SIZE];        // Last key sent
+    unsigned int sentCount;
+
+    void runScenario(void);
+    void buildWord(void);
+    void setPanel(byte cmd, const byte *data, byte len, bool chkSum);
+    void setKeypad(const byte *data, byte len);
+    bool panelBit(byte n);
+    bool keypadBit(byte n);
+    void keypadEdge(byte n, unsigned int dt);
+    bool edge(bool clk, bool data, unsigned int dt);
+};
+
+#endif
@@ -0,0 +1,101 @@
+#include "Arduino.h"
+#include "DSC_Trace.h"
+
+// VCD identifiers of the lines, in TRACE_xxx bit order
+const char traceIds[] = "!\"#";
+
+DSC_Trace::DSC_Trace(DSC &dsc, traceEdge_t *buf, unsigned int size)
+  : dsc(dsc)
+  {
+    unsigned int pow2 = 1;
+    while (pow2 <= size / 2) pow2 <<= 1;
+    trace.buf = buf;
+    trace.size = (buf && size) ? pow2 : 0;   // No buffer, no trace
+    trace.head = 0, trace.tail = 0, trace.dropped = 0;
+    out = NULL;
+    started = false;
+  }
+
+void DSC_Trace::begin(Print &out)
+  {
+    dsc.setTrace(NULL);
+    this->out = &out;
+    started = false;
+    sec = 0, usec = 0;
+    lines = 0, dropped = 0;
+    trace.head = 0, trace.tail = 0, trace.dropped = 0;
+
+    out.println(F("$version DSC keybus trace $end"));
+    out.println(F("$timescale 1us $end"));
+    out.println(F("$scope module keybus $end"));
+    out.println(F("$var wire 1 ! CLK $end"));
+    out.println(F("$var wire 1 \" DATA $end"));
+    out.println(F("$var wire 1 # KEYSEND $end"));
+    out.println(F("$upscope $end"));
+    out.println(F("$enddefinitions $end"));
+
+    if (trace.size) dsc.setTrace(&trace);
+  }
+
+void DSC_Trace::end(void)
+  {
+    dsc.setTrace(NULL);
+  }
+
+unsigned int DSC_Trace::update(unsigned int max)
+  {
+    if (!out) return 0;
+
+    // The ISR may change the index while it is being read
+    noInterrupts();
+    unsigned int head = dscLoadAcquire(trace.head);
+    unsigned int lost = trace.dropped;
+    interrupts();
+
+    if (lost != dropped) {
+      out->print(F("$comment "));
+      out->print(lost - dropped);
+      out->println(F(" edges dropped $end"));
+      dropped = lost;
+    }
+
+    unsigned int n = 0;
+    while (trace.tail != head && (!max || n < max)) {
+      writeEdge(trace.buf[trace.tail & (trace.size - 1)]);
+      dscStoreRelease(trace.tail, trace.tail + 1);  // Free the slot for the ISR
+      n++;
+    }
+    return n;
+  }
+
+void DSC_Trace::writeEdge(const traceEdge_t &e)
+  {
+    // The time from the first edge, seconds then micros, as a number of micros
+    byte changed = 0xff;
+    if (started) {
+      usec += e.us - lastUs;
+      sec += usec / 1000000UL;
+      usec %= 1000000UL;
+      changed = e.lines ^ lines;
+    }
+    started = true;
+    lastUs = e.us;
+    lines = e.lines;
+
+    out->print('#');
+    if (sec) {
+      out->print(sec);
+      for (unsigned long d=100000UL;d>1 && usec<d;d/=10) out->print('0');
+    }
+    out->println(usec);
+    for (byte i=0;i<3;i++) {
+      if (!(changed & (1 << i))) continue;
+      out->print((e.lines & (1 << i)) ? '1' : '0');
+      out->println(traceIds[i]);
+    }
+  }
+
+unsigned int DSC_Trace::get_dropped(void)
+  {
+    return trace.dropped;
+  }
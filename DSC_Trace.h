@@ -0,0 +1,62 @@
+/* DSC_Trace.h
+ * Part of DSC Library
+ * See COPYRIGHT.txt and LICENSE.txt for more information.
+ *
+ * Writes the keybus clock and data edges, as the ISR saw them, as a VCD (value change
+ * dump) file which PulseView (sigrok), GTKWave and others open, to compare with a
+ * logic analyzer or study the timing and the keypad send bit placement.  The ISR
+ * puts each edge in a small buffer and update() writes them out as they come, so a
+ * session of any length can be streamed (to a fast serial port, an SD card file, or
+ * a file on the host with DSC_Sim).  Edges which don't fit in the buffer are counted
+ * and noted in the file.
+ *
+ * Each edge is about 15 characters, at about 2000 edges a second the serial port
+ * needs to run at 500000 baud or more to keep up.
+ *
+ * For example...
+ *
+ *   traceEdge_t edges[64];
+ *   DSC_Trace trace(dsc, edges, 64);
+ *   trace.begin(Serial);            // In setup()
+ *   trace.update();                 // In loop()
+ */
+
+#ifndef DSC_Trace_h
+#define DSC_Trace_h
+#include "DSC.h"
+
+class DSC_Trace
+{
+  public:
+    // Traces the keybus of a DSC instance into "buf" of "size" edges (rounded down
+    // to a power of 2), nothing is traced if "buf" is NULL or "size" is 0
+    DSC_Trace(DSC &dsc, traceEdge_t *buf, unsigned int size);
+
+    // Writes the VCD header to "out" and starts tracing
+    void begin(Print &out);
+
+    // Stops tracing
+    void end(void);
+
+    // Writes out up to "max" edges waiting in the buffer (0 for all), returns the
+    // number written
+    unsigned int update(unsigned int max = 0);
+
+    // Returns the number of edges lost because the buffer was full
+    unsigned int get_dropped(void);
+
+  private:
+    DSC &dsc;
+    trace_t trace;
+    Print *out;
+    bool started;                   // The first edge has been written
+    unsigned long lastUs;           // micros() of the last edge written
+    unsigned long sec, usec;        // Time of the last edge from the first, split
+                                    // so it doesn't wrap with micros()
+    byte lines;                     // TRACE_xxx levels last written
+    unsigned int dropped;           // Dropped edges already noted in the file
+
+    void writeEdge(const traceEdge_t &e);
+};
+
+#endif
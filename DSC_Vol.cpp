@@ -0,0 +1,142 @@
+#include "Arduino.h"
+#include "DSC_Vol.h"
+
+DSC_Vol::DSC_Vol(void)
+  {
+    begin();
+  }
+
+void DSC_Vol::begin(void)
+  {
+    for (byte i=0;i<VOL_SLOTS;i++) slots[i].used = false;
+    startMs = millis();
+    markMs = 0, marking = false;
+    untracked = 0;
+  }
+
+volCmd_t* DSC_Vol::find(byte cmd, bool add)
+  {
+    // Returns the command's slot, taking a free one if "add", or NULL
+    volCmd_t *slot = NULL;
+    for (byte i=0;i<VOL_SLOTS;i++) {
+      if (slots[i].used && slots[i].cmd == cmd) return &slots[i];
+      if (!slots[i].used && !slot) slot = &slots[i];
+    }
+    if (!add || !slot) return NULL;
+
+    slot->used = true;
+    slot->cmd = cmd;
+    slot->len = 0;
+    slot->words = 0;
+    for (byte n=0;n<VOL_BITS;n++) {
+      slot->toggles[n] = 0;
+      slot->marked[n] = 0;
+      slot->changed[n] = 0;
+    }
+    return slot;
+  }
+
+bool DSC_Vol::track(byte cmd)
+  {
+    return find(cmd, true) != NULL;
+  }
+
+void DSC_Vol::update(const dscEvent_t &event)
+  {
+    if (event.source == DSC_KEYPAD) {
+      if (event.kpd && event.kpd->btn) mark();    // Only the buttons, not the responses
+      return;
+    }
+    byte a[PNL_ARR_SIZE];
+    for (byte i=0;i<PNL_ARR_SIZE;i++) a[i] = event.array[i];
+    update(event.cmd, a, event.len);
+  }
+
+void DSC_Vol::update(byte cmd, const byte* array, byte len)
+  {
+    volCmd_t *s = find(cmd, true);
+    if (!s) {
+      untracked++;
+      return;
+    }
+    unsigned long now = millis();
+    bool afterMark = marking && (now - markMs) < VOL_MARK_MS;
+    bool toggled = false;
+
+    // Compare each bit with the last word, only the bits both words have
+    if (s->words) {
+      byte bits = (len < s->len) ? len : s->len;
+      if (bits > VOL_BITS) bits = VOL_BITS;
+      for (byte n=0;n<bits;n++) {
+        if (DSC::wordBit(array, len, n, 1) == DSC::wordBit(s->last, s->len, n, 1)) continue;
+        toggled = true;
+        if (s->toggles[n] < 0xffff) s->toggles[n]++;
+        if (afterMark && s->marked[n] < 0xff) s->marked[n]++;
+        s->changed[n] = (now - startMs) / 1000;
+      }
+    }
+    for (byte i=0;i<PNL_ARR_SIZE;i++) s->last[i] = array[i];
+    s->len = len;
+    s->words++;
+
+    if (toggled && (cmd == 0x27 || cmd == 0x2d || cmd == 0x34 || cmd == 0x3e)) mark();
+  }
+
+void DSC_Vol::mark(void)
+  {
+    markMs = millis();
+    marking = true;
+  }
+
+void DSC_Vol::dump(Print &out)
+  {
+    for (byte i=0;i<VOL_SLOTS;i++) {
+      volCmd_t &s = slots[i];
+      if (!s.used) continue;
+      out.print(F("Cmd 0x"));
+      out.print(hex[s.cmd >> 4]);
+      out.print(hex[s.cmd & 0x0f]);
+      out.print(F(", "));
+      out.print(s.words);
+      out.println(F(" words"));
+      for (byte n=0;n<VOL_BITS;n++) {
+        if (!s.toggles[n]) continue;
+        out.print(F("  Bit "));
+        out.print(n);
+        out.print(F(": "));
+        out.print(s.toggles[n]);
+        out.print(F(" toggles, "));
+        out.print(s.marked[n]);
+        out.print(F(" after a mark, last at "));
+        out.print(s.changed[n]);
+        out.println(F(" s"));
+      }
+    }
+    if (untracked) {
+      out.print(F("Untracked words: "));
+      out.println(untracked);
+    }
+  }
+
+unsigned int DSC_Vol::get_toggles(byte cmd, byte bit)
+  {
+    volCmd_t *s = find(cmd, false);
+    return (s && bit < VOL_BITS) ? s->toggles[bit] : 0;
+  }
+
+byte DSC_Vol::get_marked(byte cmd, byte bit)
+  {
+    volCmd_t *s = find(cmd, false);
+    return (s && bit < VOL_BITS) ? s->marked[bit] : 0;
+  }
+
+unsigned int DSC_Vol::get_changed(byte cmd, byte bit)
+  {
+    volCmd_t *s = find(cmd, false);
+    return (s && bit < VOL_BITS) ? s->changed[bit] : 0;
+  }
+
+unsigned long DSC_Vol::get_untracked(void)
+  {
+    return untracked;
+  }
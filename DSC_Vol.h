@@ -0,0 +1,96 @@
+/* DSC_Vol.h
+ * Part of DSC Library
+ * See COPYRIGHT.txt and LICENSE.txt for more information.
+ *
+ * A bit volatility tracker, for finding the meaning of the unknown panel commands
+ * (0x39, 0x5d, 0x63, 0x64, 0x69, 0xb1, etc.) and bits from hours of live traffic
+ * without sending the raw words off the board.  For each command tracked it counts
+ * how often each bit of the word toggles, how many of those toggles came soon after
+ * a marked event (a keypad button, a zone change, or a call to mark()), and when
+ * each bit last toggled.
+ *
+ * For example...  fed from a callback subscribed to both panel and keypad words
+ *
+ *   DSC_Vol vol;
+ *   void onWord(const dscEvent_t &event) { vol.update(event); }
+ *   ...
+ *   vol.dump(Serial);
+ */
+
+#ifndef DSC_Vol_h
+#define DSC_Vol_h
+#include "DSC.h"
+
+// ----- Tracker Size -----
+  /*
+   * Each command tracked takes about 470 bytes of RAM.
+  */
+#if defined(__AVR_ATmega328P__) || defined(__AVR_ATmega168__) || defined(__AVR_ATmega32U4__)
+const byte VOL_SLOTS = 1;           // Number of commands which may be tracked
+#elif defined(__AVR__)
+const byte VOL_SLOTS = 4;
+#else
+const byte VOL_SLOTS = 16;
+#endif
+const byte VOL_BITS = 9 + (PNL_ARR_SIZE - 2) * 8;   // Bits tracked per word
+const unsigned int VOL_MARK_MS = 2000;   // Toggles this soon after a mark are counted
+
+typedef struct
+{
+  byte cmd;                         // Command byte
+  bool used;                        // False if the slot is free
+  byte len;                         // Length of the last word in bits
+  byte last[PNL_ARR_SIZE];          // The last word
+  unsigned long words;              // Words seen
+  unsigned int toggles[VOL_BITS];   // Times each bit toggled (stops at 65535)
+  byte marked[VOL_BITS];            // Toggles soon after a mark (stops at 255)
+  unsigned int changed[VOL_BITS];   // Seconds from begin() to the last toggle (wraps at 18 h)
+}
+volCmd_t;
+
+class DSC_Vol
+{
+  public:
+    DSC_Vol(void);
+
+    // Clears the tracker and starts its clock
+    void begin(void);
+
+    // Reserves a slot for "cmd", so the commands of interest are tracked before the
+    // slots are taken by others.  Returns false if there is no free slot
+    bool track(byte cmd);
+
+    // Adds a word, a panel word is tracked (if it has a slot) and a keypad button
+    // is a mark.  A panel zone word (0x27, 0x2d, 0x34, 0x3e) which changes is also
+    // a mark, once its own toggles have been counted
+    void update(const dscEvent_t &event);
+
+    // Adds a panel word array "len" bits long, laid out as the ISR builds it
+    void update(byte cmd, const byte* array, byte len);
+
+    // Marks an outside event, the toggles in the next VOL_MARK_MS are counted with it
+    void mark(void);
+
+    // Prints each command tracked and each of its bits which has toggled
+    //   Cmd 0x05, 1234 words
+    //     Bit 20: 12 toggles, 10 after a mark, last at 3605 s
+    void dump(Print &out);
+
+    // Returns the counts for bit "bit" of "cmd" (0 if not tracked), and the number
+    // of panel words which were not tracked as every slot was taken
+    unsigned int get_toggles(byte cmd, byte bit);
+    byte get_marked(byte cmd, byte bit);
+    unsigned int get_changed(byte cmd, byte bit);
+    unsigned long get_untracked(void);
+
+  private:
+    volCmd_t slots[VOL_SLOTS];
+    unsigned long startMs;          // millis() at begin()
+    unsigned long markMs;           // millis() at the last mark
+    bool marking;                   // A mark has been made
+    unsigned long untracked;
+
+    volCmd_t* find(byte cmd, bool add);
+};
+
+#endif
@@ -64,6 +64,7 @@ void setup()
 
   dsc.setCLK(3);    // Sets the clock pin to 3 (example, this is also the default)
                     // setDTA_IN( ), setDTA_OUT( ) and setLED( ) can also be called
+  dsc.setPartitions(1);   // 2 for a panel with two partitions, both are then in the messages
   dsc.begin();      // Start the dsc library (Sets the pin modes)
 }
 
@@ -127,7 +128,9 @@ void loop()
   }
 
   // ---------------- Get/process incoming data ----------------
-  int dscStat = dsc.process();
+  // Limit the decoding to about 2 ms per loop so the Ethernet client is serviced
+  // regularly, the rest of the word is finished on the next pass (returns -3)
+  int dscStat = dsc.process(2000);
   if (dscStat < 1) {
     if (dscStat = 0) ; //Serial.println("NONE");
     if (dscStat = -1) ;
@@ -0,0 +1,388 @@
+// DSC_18XX Arduino Interface - Benchmark Example
+//
+// - Times the decode path (decodePanel(), decodeKeypad(), byteToInt(), byteToBin(),
+//   pnlChkSum() and the get_xxxFormat/Array/Raw() formatters) over a corpus of
+//   keybus words, and checks the decoded output of each word against the golden
+//   values below, so a change to these functions can be shown to be both faster
+//   and to give exactly the same output.  No keybus or panel is needed.
+//
+// - The corpus words are encoded field by field the way the panel sends them (as
+//   DSC_Sim does, with the checksums worked out), they are not a capture.  It has
+//   the edge cases which have broken the decoder before: words whose checksum byte
+//   is 0x00, and an unknown keypad code with hex letters.  To add words from a real
+//   panel, run the Forwarder example on it: each "P41 05 00 81 01 90 c7" line it
+//   prints is one corpus row (length in bits, then the bytes), pair it with the "K"
+//   line which follows, and record new golden values as below.
+//
+// - decodeBatch() is timed on the whole corpus as one block, and its results are
+//   checked against decoding the words one at a time.
+//
+// - The results are printed as one JSON object per line, for collecting in CI:
+//     {"fn":"decodePanel","ns_per_word":123456,"heap_bytes":0}
+//     {"golden":"pass","words":18,"mismatches":0}
+//     {"batch":"pass","words":18,"mismatches":0}
+//   "heap_bytes" is how much the heap grew while the function ran (AVR only, it
+//   should be 0 as the library buffers are static), it is -1 on other boards.
+//
+// - To record a new golden corpus after an intended change to the output, set
+//   RECORD_GOLDEN to 1, and paste the printed values over golden[] below.  The
+//   decoded text of each word is printed as well, keep it with the results.
+//
+//
+
+#include <DSC.h>
+
+#define RECORD_GOLDEN 0
+
+DSC dsc;            // Initialize DSC.h library as "dsc"
+
+const unsigned int ROUNDS = 50;     // Calls of each function per word
+
+// One keybus word, laid out as the ISR builds them (panel: command, padding bit,
+// data bytes; keypad: data bytes), the lengths are in bits
+typedef struct
+{
+  byte p[PNL_ARR_SIZE];
+  byte pLen;
+  byte k[KPD_ARR_SIZE];
+  byte kLen;
+}
+benchWord_t;
+
+const benchWord_t corpus[] PROGMEM = {
+  // Ready, keypad idle
+  { { 0x05, 0x00, 0x81, 0x01, 0x90, 0xc7 }, 41,
+    { 0xff, 0xff, 0xff, 0xff, 0xff }, 40 },
+  // Armed, exit delay, key 1
+  { { 0x05, 0x00, 0x82, 0x08, 0x90, 0xc7 }, 41,
+    { 0xff, 0x82, 0xff, 0xff, 0xff }, 40 },
+  // Not ready, fire, trouble, memory, key Stay
+  { { 0x05, 0x00, 0xd4, 0x26, 0x10, 0xc7 }, 41,
+    { 0xff, 0xd7, 0xff, 0xff, 0xff }, 40 },
+  // Armed, alarm, key Exit
+  { { 0x05, 0x00, 0x82, 0x0c, 0x90, 0xc7 }, 41,
+    { 0xff, 0xf0, 0xff, 0xff, 0xff }, 40 },
+  // Zones 1 and 3 open, Fire button
+  { { 0x27, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x2c }, 57,
+    { 0xbb, 0xff, 0xff, 0xff, 0xff }, 40 },
+  // Zones 9 and 16 open, unknown key 0x44
+  { { 0x2d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x81, 0xae }, 57,
+    { 0xff, 0x44, 0xff, 0xff, 0xff }, 40 },
+  // Zones 17-24 closed, Aux button
+  { { 0x34, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x34 }, 57,
+    { 0xdd, 0xff, 0xff, 0xff, 0xff }, 40 },
+  // Zones 25-32 open, Panic button
+  { { 0x3e, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x3d }, 57,
+    { 0xee, 0xff, 0xff, 0xff, 0xff }, 40 },
+  // Checksum 0x00, unknown key 0xab (hex letters)
+  { { 0x3e, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc2, 0x00 }, 57,
+    { 0xff, 0xab, 0xff, 0xff, 0xff }, 40 },
+  // Armed by user 5
+  { { 0xa5, 0x00, 0x16, 0x2a, 0x4b, 0x20, 0x9d, 0xed }, 57,
+    { 0xff, 0xff, 0xff, 0xff, 0xff }, 40 },
+  // Disarmed by user 5
+  { { 0xa5, 0x00, 0x16, 0x2a, 0x4b, 0x20, 0xc4, 0x14 }, 57,
+    { 0xff, 0xff, 0xff, 0xff, 0xff }, 40 },
+  // Disarmed by the master code (40)
+  { { 0xa5, 0x00, 0x16, 0x2a, 0x4b, 0x20, 0xe2, 0x32 }, 57,
+    { 0xff, 0xff, 0xff, 0xff, 0xff }, 40 },
+  // Checksum 0x00, disarmed by user 1 (minute 4)
+  { { 0xa5, 0x00, 0x16, 0x2a, 0x4b, 0x10, 0xc0, 0x00 }, 57,
+    { 0xff, 0xff, 0xff, 0xff, 0xff }, 40 },
+  // Keypad query and response
+  { { 0x11, 0x00, 0xaa, 0xaa, 0x00 }, 33,
+    { 0xff, 0xff, 0xff, 0xfe, 0x7f }, 40 },
+  // Program mode
+  { { 0x0a, 0x00, 0x80, 0x01, 0x00, 0x00, 0x8b }, 49,
+    { 0xff, 0xff, 0xff, 0xff, 0xff }, 40 },
+  // Alarm memory group 1, zone 3
+  { { 0x5d, 0x00, 0x00, 0x00, 0x04, 0x00, 0x61 }, 49,
+    { 0xff, 0xff, 0xff, 0xff, 0xff }, 40 },
+  // Alarm memory group 2, none
+  { { 0x63, 0x00, 0x00, 0x63 }, 25,
+    { 0xff, 0xff, 0xff, 0xff, 0xff }, 40 },
+  // Zone configuration
+  { { 0xb1, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb0 }, 89,
+    { 0xff, 0xff, 0xff, 0xff, 0xff }, 40 } };
+
+const byte CORPUS_LEN = sizeof(corpus) / sizeof(corpus[0]);
+
+// Hash of the decoded output of each word (see hashWord())
+const uint32_t golden[] PROGMEM = {
+  0x995cf278UL,   // [Status] Ready |
+  0xb7acbd01UL,   // [Status] Armed, Exit Delay | [Button] 1
+  0x6ad76764UL,   // [Status] Not Ready, Fire, Error, Memory | [Button] Stay
+  0xa6c8529fUL,   // [Status] Armed, Alarm | [Button] Exit
+  0x324c83beUL,   // [Zones A] 1 3  | [Button] Fire
+  0x5b804c6fUL,   // [Zones B] 9 16  | [Keypad] 0x44 (Unknown)
+  0x70bc8fd9UL,   // [Zones C] Secure  | [Button] Aux
+  0x8c302f91UL,   // [Zones D] 25 26 27 28 29 30 31 32  | [Button] Panic
+  0x3f439854UL,   // [Zones D] 26 31 32  | [Keypad] 0xab (Unknown)
+  0xfb82baf3UL,   // [Info] Armed, User Code 5 |
+  0x822b97d4UL,   // [Info] Disarmed, User Code 5 |
+  0xce2ea1cdUL,   // [Info] Disarmed, Master Code 40 |
+  0xfa858650UL,   // [Info] Disarmed, User Code 1 |
+  0xedc1cb0cUL,   // [Keypad Query]  |
+  0xfa1b21b9UL,   // [Panel Program Mode]  |
+  0xa794b827UL,   // [Alarm Memory Group 1]  |
+  0x3313a214UL,   // [Alarm Memory Group 2]  |
+  0xb2a3d6e9UL    // [Zone Configuration]  |
+};
+
+benchWord_t w;      // The word being run, copied from the corpus
+
+// The corpus panel words as a batch block (byte i of word w is rows[i][w])
+byte rows[PNL_ARR_SIZE][CORPUS_LEN], lens[CORPUS_LEN];
+byte valid[CORPUS_LEN], cls[CORPUS_LEN], lights[CORPUS_LEN];
+unsigned long zones[CORPUS_LEN];
+dscBatch_t batch;
+
+pnlData_t scalar;   // Panel fields of the word decoded one at a time
+
+// --------------------------------------------------------------------------------------------------------
+// -----------------------------------------------  SETUP  ------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.flush();
+  Serial.println(F("DSC Powerseries 18XX"));
+  Serial.println(F("Decode Benchmark"));
+  Serial.println(F("Initializing"));
+
+  checkGolden();
+  checkBatch();
+
+  // The cost of loading a word, taken off the decode functions which need one
+  unsigned long loadUs = timeFn(runLoad, false);
+
+  report(F("replayWord"),      runLoad,        false, 0);
+  report(F("decodePanel"),     runDecodePanel, false, loadUs);
+  report(F("decodeKeypad"),    runDecodeKeypad, false, loadUs);
+  report(F("pnlChkSum"),       runChkSum,      false, 0);
+  report(F("byteToInt"),       runByteToInt,   false, 0);
+  report(F("byteToBin"),       runByteToBin,   false, 0);
+  report(F("get_pnlFormat"),   runPnlFormat,   true,  0);
+  report(F("get_pnlArray"),    runPnlArray,    true,  0);
+  report(F("get_pnlRaw"),      runPnlRaw,      true,  0);
+  report(F("get_kpdFormat"),   runKpdFormat,   true,  0);
+  report(F("get_kpdArray"),    runKpdArray,    true,  0);
+  report(F("get_kpdRaw"),      runKpdRaw,      true,  0);
+  reportBatch();
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  MAIN LOOP  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void loop()
+{
+  // Everything is run once, from setup()
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  FUNCTIONS  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+// ----- The functions timed, each is called ROUNDS times on each word -----
+void runLoad()         { dsc.replayWord(w.p, w.pLen, w.k, w.kLen); }
+void runDecodePanel()  { runLoad(); dsc.decodePanel(); }
+void runDecodeKeypad() { runLoad(); dsc.decodeKeypad(); }
+void runChkSum()       { dsc.pnlChkSum(); }
+void runByteToInt()    { dsc.byteToInt(w.p, 9, 8, 1); }
+void runByteToBin()    { dsc.byteToBin(w.p[0], 8); }
+void runPnlFormat()    { dsc.get_pnlFormat(); }
+void runPnlArray()     { dsc.get_pnlArray(); }
+void runPnlRaw()       { dsc.get_pnlRaw(); }
+void runKpdFormat()    { dsc.get_kpdFormat(); }
+void runKpdArray()     { dsc.get_kpdArray(); }
+void runKpdRaw()       { dsc.get_kpdRaw(); }
+
+void loadWord(byte i, bool decode)
+{
+  // Copies word "i" from the corpus, loads it, and decodes it if the function
+  // timed needs a decoded word (the get_xxx() formatters)
+  memcpy_P(&w, &corpus[i], sizeof(benchWord_t));
+  dsc.replayWord(w.p, w.pLen, w.k, w.kLen);
+  if (decode) while (dsc.process() == -3);
+}
+
+unsigned long timeFn(void (*fn)(), bool decode)
+{
+  // Returns the total micros of ROUNDS calls of "fn" on each word of the corpus
+  unsigned long total = 0;
+  for (byte i=0;i<CORPUS_LEN;i++) {
+    loadWord(i, decode);
+    unsigned long start = micros();
+    for (unsigned int r=0;r<ROUNDS;r++) fn();
+    total += micros() - start;
+  }
+  return total;
+}
+
+int heapTop()
+{
+#ifdef __AVR__
+  extern char *__brkval;
+  extern char __heap_start;
+  return (int)(__brkval ? __brkval : &__heap_start);
+#else
+  return -1;
+#endif
+}
+
+void report(const __FlashStringHelper *name, void (*fn)(), bool decode, unsigned long baseUs)
+{
+  int heap = heapTop();
+  unsigned long us = timeFn(fn, decode);
+  heap = (heap < 0) ? -1 : heapTop() - heap;
+  us = (us > baseUs) ? us - baseUs : 0;
+
+  // Nanoseconds per word, without overflowing for long runs
+  unsigned long n = (unsigned long)ROUNDS * CORPUS_LEN;
+  unsigned long ns = (us / n) * 1000UL + ((us % n) * 1000UL) / n;
+
+  Serial.print(F("{\"fn\":\""));
+  Serial.print(name);
+  Serial.print(F("\",\"ns_per_word\":"));
+  Serial.print(ns);
+  Serial.print(F(",\"heap_bytes\":"));
+  Serial.print(heap);
+  Serial.println(F("}"));
+}
+
+uint32_t hashStr(uint32_t h, const char *s)
+{
+  // FNV-1a hash of "s" (NULL is hashed as empty), followed by a separator
+  if (s) while (*s) { h ^= (byte)*s++; h *= 16777619UL; }
+  h ^= '|'; h *= 16777619UL;
+  return h;
+}
+
+uint32_t hashWord(int result)
+{
+  // Hashes everything decoded from the word loaded
+  char num[12];
+  sprintf(num, "%d %d %d", result, dsc.get_pCmd(), dsc.get_kCmd());
+  uint32_t h = hashStr(2166136261UL, num);
+  h = hashStr(h, dsc.get_pMsg());
+  h = hashStr(h, dsc.get_kMsg());
+  h = hashStr(h, dsc.get_pnlFormat());
+  h = hashStr(h, dsc.get_pnlArray());
+  h = hashStr(h, dsc.get_pnlRaw());
+  h = hashStr(h, dsc.get_kpdFormat());
+  h = hashStr(h, dsc.get_kpdArray());
+  h = hashStr(h, dsc.get_kpdRaw());
+  return h;
+}
+
+void reportBatch()
+{
+  // Nanoseconds per word of decoding the whole corpus as one block, ROUNDS times
+  int heap = heapTop();
+  unsigned long start = micros();
+  for (unsigned int r=0;r<ROUNDS;r++) DSC::decodeBatch(batch);
+  unsigned long us = micros() - start;
+  heap = (heap < 0) ? -1 : heapTop() - heap;
+
+  unsigned long n = (unsigned long)ROUNDS * CORPUS_LEN;
+  Serial.print(F("{\"fn\":\"decodeBatch\",\"ns_per_word\":"));
+  Serial.print((us / n) * 1000UL + ((us % n) * 1000UL) / n);
+  Serial.print(F(",\"heap_bytes\":"));
+  Serial.print(heap);
+  Serial.println(F("}"));
+}
+
+void onPanel(const dscEvent_t &event)
+{
+  scalar = *event.pnl;
+}
+
+void checkBatch()
+{
+  // Builds the batch block from the corpus, decodes it, and compares each word
+  // with decoding it on its own
+  for (byte i=0;i<CORPUS_LEN;i++) {
+    memcpy_P(&w, &corpus[i], sizeof(benchWord_t));
+    for (byte b=0;b<PNL_ARR_SIZE;b++) rows[b][i] = w.p[b];
+    lens[i] = w.pLen;
+  }
+  batch.count = CORPUS_LEN;
+  batch.len = lens;
+  for (byte b=0;b<PNL_ARR_SIZE;b++) batch.bytes[b] = rows[b];
+  batch.valid = valid, batch.cls = cls, batch.zones = zones, batch.lights = lights;
+  DSC::decodeBatch(batch);
+
+  int id = dsc.subscribe(onPanel, DSC_PANEL, NULL);
+  byte mismatches = 0;
+  for (byte i=0;i<CORPUS_LEN;i++) {
+    memcpy_P(&w, &corpus[i], sizeof(benchWord_t));
+    dsc.replayWord(w.p, w.pLen, w.k, w.kLen);
+    bool ok = (valid[i] == dsc.pnlChkValid());
+    while (dsc.process() == -3);
+
+    byte cmd = w.p[0];
+    byte shift = (cmd == 0x2d) ? 8 : (cmd == 0x34) ? 16 : (cmd == 0x3e) ? 24 : 0;
+    if (cls[i] == CMD_ZONES)  ok = ok && zones[i] == ((unsigned long)scalar.zones << shift);
+    if (cls[i] == CMD_STATUS) ok = ok && lights[i] == scalar.lights[0];
+    if (cmd == 0x05) ok = ok && cls[i] == CMD_STATUS;
+    if (!ok) {
+      mismatches++;
+      Serial.print(F("{\"batch_mismatch\":"));
+      Serial.print(i);
+      Serial.println(F("}"));
+    }
+  }
+  dsc.unsubscribe(id);
+
+  Serial.print(F("{\"batch\":\""));
+  Serial.print(mismatches ? F("fail") : F("pass"));
+  Serial.print(F("\",\"words\":"));
+  Serial.print(CORPUS_LEN);
+  Serial.print(F(",\"mismatches\":"));
+  Serial.print(mismatches);
+  Serial.println(F("}"));
+}
+
+void checkGolden()
+{
+  // Decodes each word of the corpus once, and compares the output with golden[]
+  byte mismatches = 0;
+  for (byte i=0;i<CORPUS_LEN;i++) {
+    memcpy_P(&w, &corpus[i], sizeof(benchWord_t));
+    dsc.replayWord(w.p, w.pLen, w.k, w.kLen);
+    int result;
+    do result = dsc.process(); while (result == -3);
+    uint32_t h = hashWord(result);
+
+#if RECORD_GOLDEN
+    Serial.print(F("  0x"));
+    for (char s=28;s>=0;s-=4) Serial.print((h >> s) & 0xf, HEX);
+    Serial.print(F("UL,   // "));
+    if (dsc.get_pCmd()) Serial.print(dsc.get_pMsg());
+    Serial.print(F(" | "));
+    if (dsc.get_kCmd()) Serial.print(dsc.get_kMsg());
+    Serial.println();
+#else
+    if (i >= sizeof(golden) / sizeof(golden[0]) || pgm_read_dword(&golden[i]) != h) {
+      mismatches++;
+      Serial.print(F("{\"mismatch\":"));
+      Serial.print(i);
+      Serial.println(F("}"));
+    }
+#endif
+  }
+
+  Serial.print(F("{\"golden\":\""));
+  Serial.print(RECORD_GOLDEN ? F("recorded") : (mismatches ? F("fail") : F("pass")));
+  Serial.print(F("\",\"words\":"));
+  Serial.print(CORPUS_LEN);
+  Serial.print(F(",\"mismatches\":"));
+  Serial.print(mismatches);
+  Serial.println(F("}"));
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ------------------------------------------------  END  -------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
@@ -0,0 +1,90 @@
+// DSC_18XX Arduino Interface - Bit Tracker Example
+//
+// - Tracks which bits of each panel command toggle, for working out the unknown
+//   commands and bits (see DSC_Vol.h).  Leave it running on a live panel, press
+//   keypad buttons and open zones, then send "d" on the serial port to print the
+//   counts, or "c" to clear them:
+//     Cmd 0x05, 1234 words
+//       Bit 20: 12 toggles, 10 after a mark, last at 3605 s
+//
+// - "after a mark" counts the toggles which came within 2 seconds of a keypad button
+//   or a zone change, a bit which mostly toggles after them is likely related.
+//
+// Sketch to decode the keybus protocol on DSC PowerSeries 1816, 1832 and 1864 panels
+//   -- Use the schematic at https://github.com/emcniece/Arduino-Keybus to connect the
+//      keybus lines to the arduino via voltage divider circuits.  Don't forget to
+//      connect the Keybus Ground to Arduino Ground (not depicted on the circuit)! You
+//      can also power your arduino from the keybus (+12 VDC, positive), depending on the
+//      the type arduino board you have.
+//
+//
+
+#include <DSC.h>
+#include <DSC_Vol.h>
+
+DSC dsc;            // Initialize DSC.h library as "dsc"
+DSC_Vol vol;        // Bit tracker
+
+// The commands of interest, tracked ahead of any others (as many as there are slots)
+const byte wanted[] = { 0x05, 0x39, 0x5d, 0x63, 0x64, 0x69, 0xb1 };
+
+// --------------------------------------------------------------------------------------------------------
+// -----------------------------------------------  SETUP  ------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.flush();
+  Serial.println(F("DSC Powerseries 18XX"));
+  Serial.println(F("Key Bus Bit Tracker"));
+  Serial.println(F("Initializing"));
+
+  // Every panel and keypad word
+  dsc.subscribe(onWord, DSC_PANEL, NULL);
+  dsc.subscribe(onWord, DSC_KEYPAD, NULL);
+
+  dsc.setCLK(3);    // Sets the clock pin to 3 (example, this is also the default)
+                    // setDTA_IN( ), setDTA_OUT( ) and setLED( ) can also be called
+  dsc.begin();      // Start the dsc library (Sets the pin modes)
+  startTracking();
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  MAIN LOOP  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void loop()
+{
+  // ---------------- Get/process incoming data ----------------
+  dsc.process();    // The words are tracked from within process()
+
+  // ---------------- Commands ----------------
+  if (Serial.available()) {
+    char c = Serial.read();
+    if (c == 'd') vol.dump(Serial);
+    if (c == 'c') {
+      startTracking();
+      Serial.println(F("Cleared"));
+    }
+  }
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  FUNCTIONS  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void startTracking()
+{
+  vol.begin();
+  for (byte i=0;i<sizeof(wanted);i++) vol.track(wanted[i]);
+}
+
+void onWord(const dscEvent_t &event)
+{
+  vol.update(event);
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ------------------------------------------------  END  -------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
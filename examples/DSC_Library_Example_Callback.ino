@@ -0,0 +1,136 @@
+// DSC_18XX Arduino Interface - Callback Example
+//
+// - Demonstrates the use of the DSC library event subscriptions. Instead of polling
+//   the get_xxx() functions, callbacks are registered for only the commands wanted,
+//   and the library skips decoding all of the other words.  Alarms, fire and the
+//   Fire/Aux/Panic buttons also come through the priority lane, ahead of the rest.
+//   Between words the board sleeps instead of polling process().
+//
+// - Two partitions are decoded, and each is only printed when its own lights
+//   change.
+//
+// Sketch to decode the keybus protocol on DSC PowerSeries 1816, 1832 and 1864 panels
+//   -- Use the schematic at https://github.com/emcniece/Arduino-Keybus to connect the
+//      keybus lines to the arduino via voltage divider circuits.  Don't forget to
+//      connect the Keybus Ground to Arduino Ground (not depicted on the circuit)! You
+//      can also power your arduino from the keybus (+12 VDC, positive), depending on the
+//      the type arduino board you have.
+//
+//
+
+#include <DSC.h>
+
+DSC dsc;            // Initialize DSC.h library as "dsc"
+
+byte pnlFilter[32]; // Panel commands wanted (bit n = command n)
+byte kpdFilter[32]; // Keypad commands wanted (bit n = command n)
+
+// --------------------------------------------------------------------------------------------------------
+// -----------------------------------------------  SETUP  ------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.flush();
+  Serial.println(F("DSC Powerseries 18XX"));
+  Serial.println(F("Key Bus Callbacks"));
+  Serial.println(F("Initializing"));
+
+  // Only the status (0x05) and info (0xa5) panel words
+  DSC::filterClear(pnlFilter);
+  DSC::filterAdd(pnlFilter, 0x05);
+  DSC::filterAdd(pnlFilter, 0xa5);
+  dsc.subscribe(onPanel, DSC_PANEL, pnlFilter);
+
+  // Only the keypad buttons
+  DSC::filterClear(kpdFilter);
+  DSC::filterAdd(kpdFilter, kOut);
+  DSC::filterAdd(kpdFilter, fire);
+  DSC::filterAdd(kpdFilter, aux);
+  DSC::filterAdd(kpdFilter, panic);
+  dsc.subscribe(onButton, DSC_KEYPAD, kpdFilter);
+
+  // Alarm, fire and the Fire/Aux/Panic buttons, as soon as they are clocked in
+  dsc.setPriorityCallback(onPriority);
+
+  dsc.setPartitions(2);   // Decode both partitions of the status word
+
+  dsc.setCLK(3);    // Sets the clock pin to 3 (example, this is also the default)
+                    // setDTA_IN( ), setDTA_OUT( ) and setLED( ) can also be called
+  dsc.begin();      // Start the dsc library (Sets the pin modes)
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  MAIN LOOP  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void loop()
+{
+  // ---------------- Get/process incoming data ----------------
+  dsc.waitWord();   // Sleep until there is a word to process
+  dsc.process();    // The callbacks are called from within process()
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  FUNCTIONS  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void onPriority(byte flags, unsigned long latency)
+{
+  Serial.print(F("PRIORITY: "));
+  if (flags & PRIO_ALARM)     Serial.print(F("Alarm "));
+  if (flags & PRIO_FIRE)      Serial.print(F("Fire "));
+  if (flags & PRIO_KEY_FIRE)  Serial.print(F("Fire Button "));
+  if (flags & PRIO_KEY_AUX)   Serial.print(F("Aux Button "));
+  if (flags & PRIO_KEY_PANIC) Serial.print(F("Panic Button "));
+  Serial.print(F("("));
+  Serial.print(latency);
+  Serial.println(F(" us)"));
+}
+
+void onPanel(const dscEvent_t &event)
+{
+  if (event.cmd == 0x05) {
+    // Only print the partitions whose lights or state have changed
+    for (byte p=1;p<=event.pnl->partitions;p++) {
+      byte changed = dsc.getLightsChanged(p) | dsc.getStateChanged(p);
+      if (changed) printPartition(p);
+    }
+  }
+  else {
+    Serial.print(F("Info: "));
+    Serial.println(event.msg);
+  }
+}
+
+void printPartition(byte p)
+{
+  byte lights = dsc.getLights(p);
+  byte state = dsc.getState(p);
+  Serial.print(F("Partition "));
+  Serial.print(p);
+  Serial.print(F(" lights: "));
+  if (lights & LIGHT_READY)   Serial.print(F("Ready "));
+  if (lights & LIGHT_ARMED)   Serial.print(F("Armed "));
+  if (lights & LIGHT_MEMORY)  Serial.print(F("Memory "));
+  if (lights & LIGHT_BYPASS)  Serial.print(F("Bypass "));
+  if (lights & LIGHT_TROUBLE) Serial.print(F("Trouble "));
+  if (lights & LIGHT_PROGRAM) Serial.print(F("Program "));
+  if (lights & LIGHT_FIRE)    Serial.print(F("Fire "));
+  if (state & STATE_EXIT_DELAY) Serial.print(F("EXIT DELAY "));
+  if (state & STATE_ALARM)      Serial.print(F("ALARM "));
+  Serial.println();
+}
+
+void onButton(const dscEvent_t &event)
+{
+  // Only button words have a name, the keypad responses are ignored
+  if (!event.kpd->btn) return;
+  Serial.print(F("Button: "));
+  Serial.println(event.kpd->btn);
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ------------------------------------------------  END  -------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
@@ -0,0 +1,86 @@
+// DSC_18XX Arduino Interface - Dual Core Example (ESP32 only)
+//
+// - Splits the library over the two ESP32 cores: the clock interrupt runs on core 0
+//   and a task on core 1 decodes each word as soon as the ISR hands it off, calling
+//   the subscribed callbacks.  A priority flag (fire, alarm) wakes the task as soon
+//   as it is raised, part way through the word.  The loop() is left free for the
+//   network (or anything slow), and doesn't call process() at all.  Here it only
+//   sends the keys typed on the serial port to the panel, from the other core.
+//
+// - The callbacks run in the decode task, so they should be short.  A slow callback
+//   only delays the following words (PIPE_DEPTH of them are queued), the clock edges
+//   are still captured on the other core.
+//
+// Sketch to decode the keybus protocol on DSC PowerSeries 1816, 1832 and 1864 panels
+//   -- Use the schematic at https://github.com/emcniece/Arduino-Keybus to connect the
+//      keybus lines to the arduino via voltage divider circuits.  Don't forget to
+//      connect the Keybus Ground to Arduino Ground (not depicted on the circuit)! You
+//      can also power your arduino from the keybus (+12 VDC, positive), depending on the
+//      the type arduino board you have.
+//
+//
+
+#include <DSC.h>
+
+DSC dsc;            // Initialize DSC.h library as "dsc"
+
+// --------------------------------------------------------------------------------------------------------
+// -----------------------------------------------  SETUP  ------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.flush();
+  Serial.println(F("DSC Powerseries 18XX"));
+  Serial.println(F("Key Bus Dual Core"));
+  Serial.println(F("Initializing"));
+
+  // Every panel word, and the keypad buttons
+  dsc.subscribe(onPanel, DSC_PANEL, NULL);
+  dsc.subscribe(onButton, DSC_KEYPAD, NULL);
+
+  dsc.setCLK(3);    // Sets the clock pin to 3 (example, this is also the default)
+                    // setDTA_IN( ), setDTA_OUT( ) and setLED( ) can also be called
+  if (!dsc.beginDualCore(0, 1)) {   // Capture on core 0, decode on core 1
+    Serial.println(F("Decode task not started"));
+  }
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  MAIN LOOP  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void loop()
+{
+  // ---------------- Send keys ----------------
+  if (Serial.available()) {
+    char c = Serial.read();
+    if (c >= '0' && c <= '9') dsc.send_key(KEY_0 + (c - '0'));
+    if (c == '*') dsc.send_key(KEY_STAR);
+    if (c == '#') dsc.send_key(KEY_POUND);
+  }
+  delay(10);        // The words are decoded by the task on the other core
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  FUNCTIONS  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void onPanel(const dscEvent_t &event)
+{
+  Serial.print(F("Panel: "));
+  Serial.println(event.msg);
+}
+
+void onButton(const dscEvent_t &event)
+{
+  // Only button words have a name, the keypad responses are ignored
+  if (!event.kpd->btn) return;
+  Serial.print(F("Button: "));
+  Serial.println(event.kpd->btn);
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ------------------------------------------------  END  -------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
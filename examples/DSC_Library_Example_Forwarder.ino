@@ -0,0 +1,79 @@
+// DSC_18XX Arduino Interface - Forwarder Example
+//
+// - Forwards the raw keybus words, one line per word, over the serial port (or a
+//   serial to IP adapter) to a gateway which decodes them, see the Gateway example.
+//   Only new words are forwarded, repeats of the same word are skipped, and the
+//   words are coalesced so a status repeated by the panel is forwarded at most once a
+//   second and no more than 10 repeats a second go over the link (see setCoalesce()).
+//
+// - Each line is "P" (panel) or "K" (keypad), the word length in bits, and the word
+//   bytes in hex as the library stores them (the panel padding bit is its own byte):
+//     P41 05 00 81 01 90 c7
+//     K40 ff 82 ff ff ff
+//
+// Sketch to decode the keybus protocol on DSC PowerSeries 1816, 1832 and 1864 panels
+//   -- Use the schematic at https://github.com/emcniece/Arduino-Keybus to connect the
+//      keybus lines to the arduino via voltage divider circuits.  Don't forget to
+//      connect the Keybus Ground to Arduino Ground (not depicted on the circuit)! You
+//      can also power your arduino from the keybus (+12 VDC, positive), depending on the
+//      the type arduino board you have.
+//
+//
+
+#include <DSC.h>
+
+DSC dsc;            // Initialize DSC.h library as "dsc"
+
+// --------------------------------------------------------------------------------------------------------
+// -----------------------------------------------  SETUP  ------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.flush();
+
+  // Every panel and keypad word
+  dsc.subscribe(forward, DSC_PANEL, NULL);
+  dsc.subscribe(forward, DSC_KEYPAD, NULL);
+  dsc.setCoalesce(1000, 10);        // 1 second window, 10 repeated words per second
+
+  dsc.setCLK(3);    // Sets the clock pin to 3 (example, this is also the default)
+                    // setDTA_IN( ), setDTA_OUT( ) and setLED( ) can also be called
+  dsc.begin();      // Start the dsc library (Sets the pin modes)
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  MAIN LOOP  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void loop()
+{
+  // ---------------- Get/process incoming data ----------------
+  dsc.process();    // The words are forwarded from within process()
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  FUNCTIONS  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void forward(const dscEvent_t &event)
+{
+  // The number of bytes holding the word, a panel word has the padding bit byte
+  byte bytes;
+  if (event.source == DSC_PANEL) bytes = (event.len > 8) ? 2 + (event.len - 9 + 7) / 8 : 1;
+  else bytes = (event.len + 7) / 8;
+
+  Serial.print(event.source == DSC_PANEL ? 'P' : 'K');
+  Serial.print(event.len);
+  for (byte i=0;i<bytes;i++) {
+    Serial.print(' ');
+    Serial.print(hex[event.array[i] >> 4]);
+    Serial.print(hex[event.array[i] & 0x0f]);
+  }
+  Serial.println();
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ------------------------------------------------  END  -------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
@@ -0,0 +1,175 @@
+// DSC_18XX Arduino Interface - Gateway Example
+//
+// - Decodes the raw keybus words forwarded from several sites (see the Forwarder
+//   example), one site on each extra serial port of the board (Mega, ESP32, etc.).
+//   No keybus is wired to the gateway itself.
+//
+// - The ports are polled without blocking and each keeps its own line buffer, so a
+//   slow or silent site never holds up the others.  Each site has its own decoder
+//   only DSC instance, on a dscBus_t state of its own (not limited to MAX_BUSES),
+//   which keeps that panel's state (lights, time, etc.), and the decoded words of
+//   every site are printed as one feed on Serial:
+//     Site 2 Panel ---> [Status] Armed
+//
+// - Every 10 seconds the throughput is printed, the words received per second, and
+//   the words per second one core could decode (words / time spent decoding).
+//
+// - For hundreds of sites on a Linux host (serial ports, pseudo-terminals, Unix or
+//   TCP sockets), see extras/gateway/dsc_gateway.cpp, which builds this library
+//   natively.
+//
+//
+
+#include <DSC.h>
+
+dscBus_t site1State, site2State;    // Each site's keybus state, no pins
+DSC site1(site1State);              // Initialize DSC.h library as "site1", decoder only
+DSC site2(site2State);              // Initialize DSC.h library as "site2", decoder only
+
+const byte LINE_LEN = 48;           // Longest forwarded line
+const unsigned long STATS_MS = 10000;
+
+typedef struct
+{
+  Stream *port;                     // Where the site's words arrive
+  DSC *dsc;                         // The site's decoder and panel state
+  char line[LINE_LEN + 1];          // Line being received
+  byte len;
+  bool overrun;                     // Line too long, skip it
+}
+site_t;
+
+site_t sites[] = {
+  { &Serial1, &site1 },
+  { &Serial2, &site2 } };
+
+const byte SITES = sizeof(sites) / sizeof(sites[0]);
+
+unsigned long words, badLines;      // Since the last stats
+unsigned long decodeUs;             // Time spent decoding since the last stats
+unsigned long lastStats;
+
+// --------------------------------------------------------------------------------------------------------
+// -----------------------------------------------  SETUP  ------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.flush();
+  Serial.println(F("DSC Powerseries 18XX"));
+  Serial.println(F("Key Bus Gateway"));
+  Serial.println(F("Initializing"));
+
+  Serial1.begin(115200);
+  Serial2.begin(115200);
+
+  for (byte i=0;i<SITES;i++) {
+    sites[i].len = 0;
+    sites[i].overrun = false;       // The words come from the port, not a keybus
+  }
+  lastStats = millis();
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  MAIN LOOP  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void loop()
+{
+  // ---------------- Take what has arrived on each port ----------------
+  for (byte i=0;i<SITES;i++) {
+    site_t &s = sites[i];
+    while (s.port->available()) {
+      char c = s.port->read();
+      if (c == '\r') continue;
+      if (c != '\n') {
+        if (s.len < LINE_LEN) s.line[s.len++] = c;
+        else s.overrun = true;
+        continue;
+      }
+      s.line[s.len] = 0;
+      if (s.len && !s.overrun) decodeLine(i);
+      s.len = 0;
+      s.overrun = false;
+    }
+  }
+
+  // ---------------- Throughput ----------------
+  if (millis() - lastStats >= STATS_MS) printStats();
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  FUNCTIONS  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void decodeLine(byte i)
+{
+  site_t &s = sites[i];
+
+  // "P41 05 00 81 01 90 c7" or "K40 ff 82 ff ff ff", see the Forwarder example
+  byte pArr[PNL_ARR_SIZE] = { 0 }, pLen = 0;
+  byte kArr[KPD_ARR_SIZE] = { 0 }, kLen = 0;
+  char *p = s.line + 1;
+  int len = strtol(p, &p, 10);
+
+  byte *arr = (s.line[0] == 'P') ? pArr : kArr;
+  byte size = (s.line[0] == 'P') ? PNL_ARR_SIZE : KPD_ARR_SIZE;
+  if ((s.line[0] != 'P' && s.line[0] != 'K') || len <= 0 || len > size * 8) {
+    badLines++;
+    return;
+  }
+  for (byte n=0;n<size;n++) {
+    char *end;
+    long b = strtol(p, &end, 16);
+    if (end == p) break;            // No more bytes
+    arr[n] = b;
+    p = end;
+  }
+  if (s.line[0] == 'P') pLen = len;
+  else kLen = len;
+
+  // ---------------- Get/process the word ----------------
+  unsigned long start = micros();
+  s.dsc->replayWord(pArr, pLen, kArr, kLen);
+  int result;
+  do result = s.dsc->process(); while (result == -3);
+  decodeUs += micros() - start;
+  words++;
+
+  if (result > 0) printWord(i + 1, *s.dsc);
+}
+
+void printWord(byte num, DSC &dsc)
+{
+  if (dsc.get_pCmd()) {
+    Serial.print(F("Site "));
+    Serial.print(num);
+    Serial.print(F(" Panel ---> "));
+    Serial.println(dsc.get_pMsg());
+  }
+  if (dsc.get_kCmd()) {
+    Serial.print(F("Site "));
+    Serial.print(num);
+    Serial.print(F(" Keypad ---> "));
+    Serial.println(dsc.get_kMsg());
+  }
+}
+
+void printStats()
+{
+  unsigned long ms = millis() - lastStats;
+  Serial.print(F("Words: "));       Serial.print(words);
+  Serial.print(F(", Words/sec: "));  Serial.print(words * 1000UL / ms);
+  Serial.print(F(", Decode words/sec: "));
+  if (decodeUs) Serial.print((unsigned long)(words * 1000000.0 / decodeUs));
+  else Serial.print(F("-"));
+  Serial.print(F(", Bad lines: "));  Serial.println(badLines);
+
+  words = 0, badLines = 0, decodeUs = 0;
+  lastStats = millis();
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ------------------------------------------------  END  -------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
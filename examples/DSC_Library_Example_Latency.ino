@@ -0,0 +1,96 @@
+// DSC_18XX Arduino Interface - Latency Example
+//
+// - Shows where the time goes from the last clock edge of a word until the sketch
+//   has the decoded message.  Every 30 seconds the latency histogram of each stage
+//   is printed, the count of words in each bucket (under 1, 4, 16 ... us):
+//     Handoff:  last edge until the ISR hands the word off (the new word gap)
+//     Queue:    handed off until process() takes it from the capture queue
+//     Delivery: taken until it is decoded and delivered
+//
+// - A slow loop() shows up in the Queue stage, and slow decoding (or callbacks) in
+//   the Delivery stage.  Set LOOP_DELAY to load the board and see the difference.
+//
+// Sketch to decode the keybus protocol on DSC PowerSeries 1816, 1832 and 1864 panels
+//   -- Use the schematic at https://github.com/emcniece/Arduino-Keybus to connect the
+//      keybus lines to the arduino via voltage divider circuits.  Don't forget to
+//      connect the Keybus Ground to Arduino Ground (not depicted on the circuit)! You
+//      can also power your arduino from the keybus (+12 VDC, positive), depending on the
+//      the type arduino board you have.
+//
+//
+
+#include <DSC.h>
+
+DSC dsc;            // Initialize DSC.h library as "dsc"
+
+const unsigned long REPORT_MS = 30000;
+const unsigned int LOOP_DELAY = 0;  // Extra ms each loop, to load the board
+
+unsigned long lastReport;
+
+// --------------------------------------------------------------------------------------------------------
+// -----------------------------------------------  SETUP  ------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.flush();
+  Serial.println(F("DSC Powerseries 18XX"));
+  Serial.println(F("Key Bus Latency"));
+  Serial.println(F("Initializing"));
+
+  dsc.setCLK(3);    // Sets the clock pin to 3 (example, this is also the default)
+                    // setDTA_IN( ), setDTA_OUT( ) and setLED( ) can also be called
+  dsc.begin();      // Start the dsc library (Sets the pin modes)
+  lastReport = millis();
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  MAIN LOOP  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void loop()
+{
+  // ---------------- Get/process incoming data ----------------
+  dsc.process();
+  if (LOOP_DELAY) delay(LOOP_DELAY);
+
+  // ---------------- Latency report ----------------
+  if (millis() - lastReport >= REPORT_MS) {
+    printStage(F("Handoff:  "), LAT_HANDOFF);
+    printStage(F("Queue:    "), LAT_QUEUE);
+    printStage(F("Delivery: "), LAT_DELIVERY);
+    Serial.println();
+    dsc.clearLatency();
+    lastReport = millis();
+  }
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  FUNCTIONS  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void printStage(const __FlashStringHelper *name, byte stage)
+{
+  // One count per bucket, "<1:0 <4:2 <16:5 ... >=65536:0"
+  Serial.print(name);
+  unsigned long limit = 1;
+  for (byte b=0;b<LAT_BUCKETS;b++) {
+    if (b < LAT_BUCKETS - 1) Serial.print('<');
+    else {
+      Serial.print(F(">="));
+      limit /= 4;
+    }
+    Serial.print(limit);
+    Serial.print(':');
+    Serial.print(dsc.get_latency(stage, b));
+    Serial.print(' ');
+    limit *= 4;
+  }
+  Serial.println();
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ------------------------------------------------  END  -------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
@@ -0,0 +1,150 @@
+// DSC_18XX Arduino Interface - Simulator Example
+//
+// - Demonstrates the DSC_Sim virtual panel, no keybus or panel is needed.  A scenario
+//   script is run over and over, as fast as possible, and the decoded words are
+//   checked at the end of each pass: every scripted event must have been seen exactly
+//   once, and the key sent with send_key() must have been seen on the keybus.
+//
+// - This can be left running as a soak test of the decoding, the dedup and the key
+//   sending.  At full speed, days of keybus traffic are run in minutes.
+//
+//
+
+#include <DSC.h>
+#include <DSC_Sim.h>
+
+DSC dsc;            // Initialize DSC.h library as "dsc"
+DSC_Sim sim(dsc);   // The virtual panel, which feeds the keybus edges to "dsc"
+
+// The scenario, times are from the start of each pass (millis)
+const simStep_t scenario[] = {
+  { 10000, SIM_ZONE_OPEN,  3   },
+  { 20000, SIM_ZONE_CLOSE, 3   },
+  { 30000, SIM_ARM,        5   },
+  { 40000, SIM_KEY,        one },
+  { 50000, SIM_DISARM,     5   },
+  { 60000, SIM_END,        0   } };
+
+const unsigned long SEND_MS = 45000;  // When the key is sent in each pass
+
+byte pnlFilter[32]; // Panel commands wanted (bit n = command n)
+byte kpdFilter[32]; // Keypad commands wanted (bit n = command n)
+
+// Events seen in the current pass
+byte zoneOpens, zoneCloses, arms, disarms, keys;
+bool zone3;
+bool keySent;
+unsigned int lastSent;
+unsigned long pass, passed, failed;
+
+// --------------------------------------------------------------------------------------------------------
+// -----------------------------------------------  SETUP  ------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.flush();
+  Serial.println(F("DSC Powerseries 18XX"));
+  Serial.println(F("Key Bus Simulator"));
+  Serial.println(F("Initializing"));
+
+  // The zone A (0x27) and info (0xa5) panel words
+  DSC::filterClear(pnlFilter);
+  DSC::filterAdd(pnlFilter, 0x27);
+  DSC::filterAdd(pnlFilter, 0xa5);
+  dsc.subscribe(onPanel, DSC_PANEL, pnlFilter);
+
+  // The keypad buttons
+  DSC::filterClear(kpdFilter);
+  DSC::filterAdd(kpdFilter, kOut);
+  dsc.subscribe(onButton, DSC_KEYPAD, kpdFilter);
+
+  sim.setSpeed(0);               // As fast as possible, 1 = real time
+  sim.begin(scenario, true);     // Detaches "dsc" from its pins, it is fed from "sim" instead
+  startPass();
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  MAIN LOOP  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void loop()
+{
+  // ---------------- Run the virtual panel ----------------
+  if (!sim.update()) return;
+
+  // ---------------- Get/process incoming data ----------------
+  while (dsc.process() != -1);   // The callbacks are called from within process()
+
+  // ---------------- Send a key once in each pass ----------------
+  if (!keySent && sim.getTime() >= SEND_MS) keySent = dsc.send_key(KEY_2);
+
+  // ---------------- Check the pass just completed ----------------
+  if (sim.getPasses() != pass) {
+    checkPass();
+    startPass();
+  }
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  FUNCTIONS  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void onPanel(const dscEvent_t &event)
+{
+  if (event.cmd == 0x27) {
+    // Zone 3 is bit 2 of zone group A, count its changes
+    bool open = event.pnl->zones & (1 << 2);
+    if (open && !zone3) zoneOpens++;
+    if (!open && zone3) zoneCloses++;
+    zone3 = open;
+  }
+  else if (event.pnl->user == 5) {
+    if (event.pnl->arm == 0x02) arms++;
+    if (event.pnl->arm == 0x03) disarms++;
+  }
+}
+
+void onButton(const dscEvent_t &event)
+{
+  if (event.kpd->code == one) keys++;
+}
+
+void startPass()
+{
+  zoneOpens = 0, zoneCloses = 0, arms = 0, disarms = 0, keys = 0;
+  keySent = false;
+  lastSent = sim.getSent(NULL);
+  pass = sim.getPasses();
+}
+
+void checkPass()
+{
+  byte sent[4];
+  bool sentOk = (sim.getSent(sent) != lastSent) && sent[0] == kOut && sent[1] == two;
+  bool ok = zoneOpens == 1 && zoneCloses == 1 && arms == 1 && disarms == 1 && keys == 1 && sentOk;
+
+  if (ok) passed++;
+  else failed++;
+
+  Serial.print(F("Pass "));
+  Serial.print(pass + 1);
+  Serial.print(ok ? F(" PASS") : F(" FAIL"));
+  if (!ok) {
+    Serial.print(F(" (zone open ")); Serial.print(zoneOpens);
+    Serial.print(F(", close "));     Serial.print(zoneCloses);
+    Serial.print(F(", arm "));       Serial.print(arms);
+    Serial.print(F(", disarm "));    Serial.print(disarms);
+    Serial.print(F(", key "));       Serial.print(keys);
+    Serial.print(F(", sent "));      Serial.print(sentOk);
+    Serial.print(F(")"));
+  }
+  Serial.print(F("  Total passed: ")); Serial.print(passed);
+  Serial.print(F(", failed: "));       Serial.print(failed);
+  Serial.print(F(", overflows: "));    Serial.println(dsc.get_overflows(DSC_PANEL));
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ------------------------------------------------  END  -------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
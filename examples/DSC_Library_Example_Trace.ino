@@ -0,0 +1,65 @@
+// DSC_18XX Arduino Interface - Trace Example
+//
+// - Streams the keybus clock and data edges, as the ISR saw them, over the serial
+//   port as a VCD file (see DSC_Trace.h).  Capture the port to a file, for example
+//   with "cat /dev/ttyUSB0 > keybus.vcd", and open it in PulseView (sigrok) or
+//   GTKWave to compare it with a logic analyzer.  The KEYSEND line shows the bits
+//   pulled low by send_key().
+//
+// - The port runs at 500000 baud to keep up with the edges, if it can't the edges
+//   lost are noted in the file as comments.
+//
+// Sketch to decode the keybus protocol on DSC PowerSeries 1816, 1832 and 1864 panels
+//   -- Use the schematic at https://github.com/emcniece/Arduino-Keybus to connect the
+//      keybus lines to the arduino via voltage divider circuits.  Don't forget to
+//      connect the Keybus Ground to Arduino Ground (not depicted on the circuit)! You
+//      can also power your arduino from the keybus (+12 VDC, positive), depending on the
+//      the type arduino board you have.
+//
+//
+
+#include <DSC.h>
+#include <DSC_Trace.h>
+
+DSC dsc;            // Initialize DSC.h library as "dsc"
+
+traceEdge_t edges[128];             // Edges waiting to be written
+DSC_Trace trace(dsc, edges, 128);
+
+// --------------------------------------------------------------------------------------------------------
+// -----------------------------------------------  SETUP  ------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void setup()
+{
+  Serial.begin(500000);
+  Serial.flush();
+
+  dsc.setCLK(3);    // Sets the clock pin to 3 (example, this is also the default)
+                    // setDTA_IN( ), setDTA_OUT( ) and setLED( ) can also be called
+  dsc.begin();      // Start the dsc library (Sets the pin modes)
+  trace.begin(Serial);              // Write the VCD header, start tracing
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  MAIN LOOP  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void loop()
+{
+  // ---------------- Get/process incoming data ----------------
+  dsc.process();    // Keep the capture queue moving, nothing is printed
+
+  // ---------------- Write out the edges ----------------
+  trace.update(16);                 // A few at a time, so process() keeps up too
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  FUNCTIONS  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+// None
+
+// --------------------------------------------------------------------------------------------------------
+// ------------------------------------------------  END  -------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
@@ -0,0 +1,78 @@
+// DSC_18XX Arduino Interface - Two Panel Example
+//
+// - Demonstrates monitoring two separately wired keybuses from one board (Mega,
+//   ESP32, etc.), each DSC instance is given its own keybus number and pins
+//
+// Sketch to decode the keybus protocol on DSC PowerSeries 1816, 1832 and 1864 panels
+//   -- Use the schematic at https://github.com/emcniece/Arduino-Keybus to connect the
+//      keybus lines to the arduino via voltage divider circuits.  Don't forget to
+//      connect the Keybus Ground to Arduino Ground (not depicted on the circuit)! You
+//      can also power your arduino from the keybus (+12 VDC, positive), depending on the
+//      the type arduino board you have.
+//
+//
+
+#include <DSC.h>
+
+DSC dsc1(0);        // Initialize DSC.h library as "dsc1" on keybus 0
+DSC dsc2(1);        // Initialize DSC.h library as "dsc2" on keybus 1
+
+// --------------------------------------------------------------------------------------------------------
+// -----------------------------------------------  SETUP  ------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void setup()
+{
+  Serial.begin(115200);
+  Serial.flush();
+  Serial.println(F("DSC Powerseries 18XX"));
+  Serial.println(F("Two Key Bus Monitor"));
+  Serial.println(F("Initializing"));
+
+  dsc1.setCLK(3);     // Both clock pins must be interrupt capable
+  dsc1.setDTA_IN(4);
+  dsc1.setDTA_OUT(8);
+  dsc1.setLED(13);
+  dsc1.begin();
+
+  dsc2.setCLK(2);
+  dsc2.setDTA_IN(5);
+  dsc2.setDTA_OUT(9);
+  dsc2.setLED(12);
+  if (!dsc2.begin()) Serial.println(F("Keybus 1 is not available (see MAX_BUSES)"));
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  MAIN LOOP  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void loop()
+{
+  // ---------------- Get/process incoming data ----------------
+  if (dsc1.process() > 0) printWord(1, dsc1);
+  if (dsc2.process() > 0) printWord(2, dsc2);
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  FUNCTIONS  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+void printWord(byte num, DSC &dsc)
+{
+  if (dsc.get_pCmd()) {
+    Serial.print(F("Panel "));
+    Serial.print(num);
+    Serial.print(F(" ---> "));
+    Serial.println(dsc.get_pMsg());
+  }
+  if (dsc.get_kCmd()) {
+    Serial.print(F("Keypad "));
+    Serial.print(num);
+    Serial.print(F(" ---> "));
+    Serial.println(dsc.get_kMsg());
+  }
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ------------------------------------------------  END  -------------------------------------------------
+// --------------------------------------------------------------------------------------------------------
@@ -34,6 +34,7 @@ void setup()
  
   dsc.setCLK(3);    // Sets the clock pin to 3 (example, this is also the default)
                     // setDTA_IN( ), setDTA_OUT( ) and setLED( ) can also be called
+  dsc.setPartitions(1);   // 2 for a panel with two partitions, both are then in the messages
   dsc.begin();      // Start the dsc library (Sets the pin modes)
 }
 
@@ -0,0 +1,133 @@
+// DSC_18XX Arduino Interface - Host Arduino.h for the Linux Gateway
+//
+// - Just enough of the Arduino core for the library's decoder (DSC.cpp) to build
+//   natively on Linux, see dsc_gateway.cpp.  There are no pins or interrupts: the
+//   pin functions do nothing, and the decoder instances are fed the forwarded words
+//   (see DSC(dscBus_t &state)).  millis() and micros() run from the monotonic clock.
+//   The host tests (extras/tests) build it with DSC_HOST_TEST_CLOCK, for a clock 
+//   they set themselves.
+//
+// - PROGMEM data is ordinary memory here, so the pgm_read_xxx() functions are plain
+//   reads.  Print writes each character through write(uint8_t), like the Arduino one.
+//
+//
+
+#ifndef DSC_HOST_ARDUINO_H
+#define DSC_HOST_ARDUINO_H
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifndef ARDUINO
+#define ARDUINO 100                 // The library takes the Arduino 1.0 includes
+#endif
+
+typedef uint8_t byte;
+typedef bool boolean;
+
+// ----- Print Bases, Pin Modes -----
+#define DEC 10
+#define HEX 16
+#define BIN 2
+#define INPUT  0
+#define OUTPUT 1
+#define CHANGE 1
+
+// ----- Program Memory -----
+#define PROGMEM
+#define PSTR(s) (s)
+#define pgm_read_byte(p)  (*(const uint8_t *)(p))
+#define pgm_read_word(p)  (*(const uint16_t *)(p))
+#define pgm_read_dword(p) (*(const uint32_t *)(p))
+#define pgm_read_ptr(p)   (*(void * const *)(p))
+#define memcpy_P memcpy
+#define strlen_P strlen
+
+class __FlashStringHelper;
+#define F(s) (reinterpret_cast<const __FlashStringHelper *>(s))
+
+// ----- Time -----
+#if defined(DSC_HOST_TEST_CLOCK)
+// The tests' clock, each micros() call moves it on by hostClockStep() micros (1 by
+// default), so a test runs the same every time.  A test may set both.
+inline unsigned long &hostClockUs(void) { static unsigned long us; return us; }
+inline unsigned long &hostClockStep(void) { static unsigned long step = 1; return step; }
+
+inline unsigned long micros(void)
+  {
+    return __atomic_add_fetch(&hostClockUs(), hostClockStep(), __ATOMIC_RELAXED);
+  }
+
+inline unsigned long millis(void)
+  {
+    return __atomic_load_n(&hostClockUs(), __ATOMIC_RELAXED) / 1000;
+  }
+#else
+inline unsigned long micros(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+  }
+
+inline unsigned long millis(void)
+  {
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (unsigned long)ts.tv_sec * 1000UL + ts.tv_nsec / 1000000;
+  }
+#endif
+
+// ----- Pins and Interrupts, there are none -----
+inline void pinMode(int, int) {}
+inline int  digitalRead(int) { return 0; }
+inline void digitalWrite(int, int) {}
+inline int  digitalPinToInterrupt(int p) { return p; }
+inline void attachInterrupt(int, void (*)(void), int) {}
+inline void detachInterrupt(int) {}
+inline void interrupts(void) {}
+inline void noInterrupts(void) {}
+
+// ----- Print -----
+class Print
+{
+  public:
+    virtual ~Print(void) {}
+    virtual size_t write(uint8_t c) = 0;
+    virtual size_t write(const uint8_t *buf, size_t n)
+      {
+        size_t r = 0;
+        while (n--) r += write(*buf++);
+        return r;
+      }
+    size_t write(const char *s) { return s ? write((const uint8_t *)s, strlen(s)) : 0; }
+
+    size_t print(const char *s) { return write(s); }
+    size_t print(const __FlashStringHelper *s) { return write((const char *)s); }
+    size_t print(char c) { return write((uint8_t)c); }
+    size_t print(unsigned char v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(int v, int base = DEC) { return print((long)v, base); }
+    size_t print(unsigned int v, int base = DEC) { return print((unsigned long)v, base); }
+    size_t print(long v, int base = DEC)
+      {
+        if (v < 0 && base == DEC) return write('-') + print((unsigned long)-v, base);
+        return print((unsigned long)v, base);
+      }
+    size_t print(unsigned long v, int base = DEC)
+      {
+        char buf[8 * sizeof(long) + 1];
+        char *p = buf + sizeof(buf) - 1;
+        *p = 0;
+        do { *--p = "0123456789ABCDEF"[v % base]; v /= base; } while (v);
+        return write(p);
+      }
+
+    size_t println(void) { return write("\r\n"); }
+    template <class T> size_t println(T v) { return print(v) + println(); }
+    template <class T> size_t println(T v, int base) { return print(v, base) + println(); }
+};
+
+#endif
@@ -0,0 +1,700 @@
+// DSC_18XX Arduino Interface - Linux Gateway
+//
+// - Decodes the raw keybus words forwarded from many sites (see the Forwarder
+//   example) on a Linux host, with the library's own decoder, for a head-end
+//   collecting hundreds of panels.  Each site is one stream of Forwarder lines:
+//     P41 05 00 81 01 90 c7
+//     K40 ff 82 ff ff ff
+//   arriving on a serial port, a pseudo-terminal, a Unix socket or a TCP connection
+//   (from a serial to IP adapter, for example).
+//
+// - The streams are multiplexed with epoll on a pool of worker threads.  Each stream
+//   stays on one worker for its life, so its decoder is never shared, and a slow or
+//   silent site never holds up the others (one read per wakeup).  Each site has its
+//   own decoder and panel state (DSC(dscBus_t &state), not limited to MAX_BUSES),
+//   and the events of every site are written to stdout as one feed, one JSON object
+//   per line:
+//     {"site":3,"name":"tcp:10.0.0.7:4410","event":"open"}
+//     {"site":3,"src":"panel","cmd":5,"msg":"[Status] Armed"}
+//     {"site":3,"partition":1,"state":2,"changed":3}
+//     {"site":3,"event":"close","words":1200,"bad_lines":0}
+//   (state/changed are the STATE_xxx bits).  Every 10 seconds a stats line gives the
+//   words/sec received, and for each worker the words per second of its CPU time.
+//
+// - Build, from the library folder (the Arduino.h here stands in for the core):
+//     g++ -std=gnu++11 -O2 -pthread -I extras/gateway -I .
+//         extras/gateway/dsc_gateway.cpp DSC.cpp -o dsc_gateway
+//
+// - Run:
+//     dsc_gateway [-w workers] [-u socket] [-p port] [-t ptys] [-n partitions]
+//                 [-c window_ms] [device ...]
+//   -w  worker threads (default: one per core)
+//   -u  listens on a Unix socket, each connection is a site:
+//         socat -u FILE:capture.txt UNIX-CONNECT:/tmp/dsc.sock
+//   -p  listens on a TCP port, each connection is a site
+//   -t  opens pseudo-terminals, one site each, and prints their names, a capture
+//       can then be played in as if from a board:  cat capture.txt > /dev/pts/7
+//   -n  partitions decoded from the status word (default 1)
+//   -c  coalesce window in ms, see setCoalesce() (default 1000, 0 for off)
+//   device  serial ports (115200 raw), one site each
+//
+// - Benchmark and self test:  dsc_gateway -b 200 [-k 1000] [-w 4] [-t 1]
+//   Plays the corpus below (the Benchmark example's words) "-k" times into each of
+//   "-b" streams over Unix socket pairs (or pseudo-terminals with -t), through the
+//   same epoll and decode path, and checks every word was decoded as when decoded on
+//   its own.  Prints the words/sec overall and for each worker per second of its CPU
+//   time (words/sec per core), and exits with 1 if a word was lost or decoded
+//   differently.
+//
+//
+
+#include <Arduino.h>
+#include <DSC.h>
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <termios.h>
+#include <unistd.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+
+const byte LINE_LEN = 48;           // Longest forwarded line
+const int READ_LEN = 4096;          // Read per wakeup of a stream
+const int EVENTS = 64;              // Streams handled per epoll_wait()
+const unsigned long STATS_MS = 10000;
+
+// The Benchmark example's corpus, as the Forwarder sends it
+const char *corpus[] = {
+  "P41 05 00 81 01 90 c7",                      "K40 ff ff ff ff ff",
+  "P41 05 00 82 08 90 c7",                      "K40 ff 82 ff ff ff",
+  "P41 05 00 d4 26 10 c7",                      "K40 ff d7 ff ff ff",
+  "P41 05 00 82 0c 90 c7",                      "K40 ff f0 ff ff ff",
+  "P57 27 00 00 00 00 00 05 2c",                "K40 bb ff ff ff ff",
+  "P57 2d 00 00 00 00 00 81 ae",                "K40 ff 44 ff ff ff",
+  "P57 34 00 00 00 00 00 00 34",                "K40 dd ff ff ff ff",
+  "P57 3e 00 00 00 00 00 ff 3d",                "K40 ee ff ff ff ff",
+  "P57 3e 00 00 00 00 00 c2 00",                "K40 ff ab ff ff ff",
+  "P57 a5 00 16 2a 4b 20 9d ed",
+  "P57 a5 00 16 2a 4b 20 c4 14",
+  "P57 a5 00 16 2a 4b 20 e2 32",
+  "P57 a5 00 16 2a 4b 10 c0 00",
+  "P33 11 00 aa aa 00",                         "K40 ff ff ff fe 7f",
+  "P49 0a 00 80 01 00 00 8b",
+  "P49 5d 00 00 00 04 00 61",
+  "P25 63 00 00 63",
+  "P89 b1 00 ff 00 00 00 00 00 00 00 00 b0" };
+
+const int CORPUS_LEN = sizeof(corpus) / sizeof(corpus[0]);
+
+// One forwarded stream, and the decoder and panel state of its site
+struct site_t
+{
+  int fd;                           // Where the site's words arrive
+  int keepFd;                       // Pty slave held open between writers, or -1
+  unsigned id;
+  std::string name;
+  dscBus_t state;                   // The site's keybus state...
+  DSC dsc;                          // ...and its decoder
+  char line[LINE_LEN + 1];          // Line being received
+  byte len;
+  bool overrun;                     // Line too long, skip it
+  unsigned long words, badLines;
+  int corpusLine;                   // Bench: position in the corpus...
+  uint32_t hash;                    // ...and hash of this round's output
+
+  site_t() : fd(-1), keepFd(-1), id(0), state(), dsc(state), len(0), overrun(false),
+             words(0), badLines(0), corpusLine(0), hash(2166136261u) {}
+};
+
+// One worker thread, and the streams it decodes
+struct worker_t
+{
+  int epfd;
+  std::thread thread;
+  std::string out;                  // Events of this wakeup, written as one block
+  std::atomic<unsigned long> words; // Since the start
+  std::atomic<unsigned long> cpuUs; // Thread CPU time, updated each wakeup
+  unsigned long lastWords, lastCpuUs;   // At the last stats
+
+  worker_t() : epfd(-1), words(0), cpuUs(0), lastWords(0), lastCpuUs(0) {}
+};
+
+std::vector<worker_t*> workers;
+std::atomic<bool> stopping(false);
+std::atomic<int> liveSites(0);
+std::atomic<unsigned> nextSite(1);
+std::atomic<unsigned long> badLines(0);
+std::mutex outLock;
+
+byte partitions = 1;
+unsigned int coalesceMs = 1000;
+
+// Bench: output hash of one corpus round decoded on its own, and the mismatches
+bool bench = false;
+uint32_t benchHash;
+std::atomic<unsigned long> benchBad(0);
+
+// --------------------------------------------------------------------------------------------------------
+// ---------------------------------------------  FUNCTIONS  ----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+static unsigned long threadCpuUs(void)
+{
+  struct timespec ts;
+  clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+  return ts.tv_sec * 1000000UL + ts.tv_nsec / 1000;
+}
+
+static void setNonBlock(int fd)
+{
+  fcntl(fd, F_SETFL, fcntl(fd, F_GETFL) | O_NONBLOCK);
+}
+
+// Raw mode, and 115200 baud for a serial port
+static void setRaw(int fd)
+{
+  struct termios tio;
+  if (tcgetattr(fd, &tio) < 0) return;
+  cfmakeraw(&tio);
+  cfsetspeed(&tio, B115200);
+  tio.c_cflag |= CLOCAL | CREAD;
+  tcsetattr(fd, TCSANOW, &tio);
+}
+
+static void addJson(std::string &out, const char *s)
+{
+  out += '"';
+  for (; *s; s++) {
+    char c = *s;
+    if (c == '"' || c == '\\') { out += '\\'; out += c; }
+    else if ((unsigned char)c < 0x20) {
+      char esc[8];
+      snprintf(esc, sizeof(esc), "\\u%04x", c);
+      out += esc;
+    }
+    else out += c;
+  }
+  out += '"';
+}
+
+static void addNum(std::string &out, const char *key, unsigned long n)
+{
+  char buf[40];
+  snprintf(buf, sizeof(buf), ",\"%s\":%lu", key, n);
+  out += buf;
+}
+
+static void addSiteHead(std::string &out, const site_t &s)
+{
+  char buf[24];
+  snprintf(buf, sizeof(buf), "{\"site\":%u", s.id);
+  out += buf;
+}
+
+// Writes the events of a wakeup to stdout, whole lines at a time
+static void flushOut(std::string &out)
+{
+  if (out.empty()) return;
+  std::lock_guard<std::mutex> lock(outLock);
+  fwrite(out.data(), 1, out.size(), stdout);
+  fflush(stdout);
+  out.clear();
+}
+
+static uint32_t hashText(uint32_t h, byte cmd, const char *msg)
+{
+  h = (h ^ cmd) * 16777619u;
+  for (; *msg; msg++) h = (h ^ (byte)*msg) * 16777619u;
+  return h;
+}
+
+// Parses "P41 05 00 81 01 90 c7" or "K40 ff 82 ff ff ff", false if malformed
+static bool parseLine(const char *line, byte *pArr, byte &pLen, byte *kArr, byte &kLen)
+{
+  char *p = (char*)line + 1;
+  long len = strtol(p, &p, 10);
+
+  byte *arr = (line[0] == 'P') ? pArr : kArr;
+  byte size = (line[0] == 'P') ? PNL_ARR_SIZE : KPD_ARR_SIZE;
+  if ((line[0] != 'P' && line[0] != 'K') || len <= 0 || len > size * 8) return false;
+  for (byte n=0;n<size;n++) {
+    char *end;
+    long b = strtol(p, &end, 16);
+    if (end == p) break;            // No more bytes
+    arr[n] = b;
+    p = end;
+  }
+  if (line[0] == 'P') pLen = len;
+  else kLen = len;
+  return true;
+}
+
+// Decodes one line on "dsc", returns the process() result, or -4 if malformed
+static int decodeLine(DSC &dsc, const char *line)
+{
+  byte pArr[PNL_ARR_SIZE] = { 0 }, pLen = 0;
+  byte kArr[KPD_ARR_SIZE] = { 0 }, kLen = 0;
+  if (!parseLine(line, pArr, pLen, kArr, kLen)) return -4;
+
+  dsc.replayWord(pArr, pLen, kArr, kLen);
+  int result;
+  do result = dsc.process(); while (result == -3);
+  return result;
+}
+
+static uint32_t hashWord(uint32_t h, DSC &dsc)
+{
+  if (dsc.get_pCmd()) h = hashText(h, dsc.get_pCmd(), dsc.get_pMsg());
+  if (dsc.get_kCmd()) h = hashText(h, dsc.get_kCmd(), dsc.get_kMsg());
+  return h;
+}
+
+static void printWord(std::string &out, site_t &s)
+{
+  if (s.dsc.get_pCmd()) {
+    addSiteHead(out, s);
+    out += ",\"src\":\"panel\"";
+    addNum(out, "cmd", s.dsc.get_pCmd());
+    out += ",\"msg\":";
+    addJson(out, s.dsc.get_pMsg());
+    out += "}\n";
+  }
+  if (s.dsc.get_kCmd()) {
+    addSiteHead(out, s);
+    out += ",\"src\":\"keypad\"";
+    addNum(out, "cmd", s.dsc.get_kCmd());
+    out += ",\"msg\":";
+    addJson(out, s.dsc.get_kMsg());
+    out += "}\n";
+  }
+  for (byte p=1;p<=partitions;p++) {
+    byte changed = s.dsc.getStateChanged(p);
+    if (!changed) continue;
+    addSiteHead(out, s);
+    addNum(out, "partition", p);
+    addNum(out, "state", s.dsc.getState(p));
+    addNum(out, "changed", changed);
+    out += "}\n";
+  }
+}
+
+// A whole line has arrived on the site's stream
+static void siteLine(worker_t &w, site_t &s)
+{
+  int result = decodeLine(s.dsc, s.line);
+  if (result == -4) {
+    s.badLines++;
+    badLines++;
+    return;
+  }
+  s.words++;
+  w.words.fetch_add(1, std::memory_order_relaxed);
+
+  if (!bench) {
+    if (result > 0) printWord(w.out, s);
+    return;
+  }
+
+  // Bench: each corpus round must decode as it did on its own
+  if (result > 0) s.hash = hashWord(s.hash, s.dsc);
+  if (strcmp(s.line, corpus[s.corpusLine]) != 0) benchBad++;
+  if (++s.corpusLine == CORPUS_LEN) {
+    if (s.hash != benchHash) benchBad++;
+    s.corpusLine = 0;
+    s.hash = 2166136261u;
+  }
+}
+
+// Takes what has arrived on the site's stream, false once it is closed
+static bool siteRead(worker_t &w, site_t &s)
+{
+  char buf[READ_LEN];
+  ssize_t n = read(s.fd, buf, sizeof(buf));
+  if (n < 0) return (errno == EAGAIN || errno == EINTR);
+  if (n == 0) return false;         // EOF (a pty gives EIO instead)
+
+  for (ssize_t i=0;i<n;i++) {
+    char c = buf[i];
+    if (c == '\r') continue;
+    if (c != '\n') {
+      if (s.len < LINE_LEN) s.line[s.len++] = c;
+      else s.overrun = true;
+      continue;
+    }
+    s.line[s.len] = 0;
+    if (s.len && !s.overrun) siteLine(w, s);
+    s.len = 0;
+    s.overrun = false;
+  }
+  return true;
+}
+
+static void siteClose(worker_t &w, site_t *s)
+{
+  epoll_ctl(w.epfd, EPOLL_CTL_DEL, s->fd, NULL);
+  close(s->fd);
+  if (s->keepFd >= 0) close(s->keepFd);
+  if (!bench) {
+    addSiteHead(w.out, *s);
+    w.out += ",\"event\":\"close\"";
+    addNum(w.out, "words", s->words);
+    addNum(w.out, "bad_lines", s->badLines);
+    w.out += "}\n";
+  }
+  delete s;
+  liveSites--;
+}
+
+static void workerLoop(worker_t *w)
+{
+  struct epoll_event ev[EVENTS];
+  while (!stopping) {
+    int n = epoll_wait(w->epfd, ev, EVENTS, 250);
+    for (int i=0;i<n;i++) {
+      site_t *s = (site_t*)ev[i].data.ptr;
+      if (!siteRead(*w, *s)) siteClose(*w, s);
+    }
+    flushOut(w->out);
+    w->cpuUs = threadCpuUs();
+  }
+}
+
+// Hands a new stream to the next worker, "keepFd" is closed with it
+static site_t* siteAdd(int fd, const std::string &name, int keepFd = -1)
+{
+  site_t *s = new site_t;
+  s->fd = fd;
+  s->keepFd = keepFd;
+  s->id = nextSite++;
+  s->name = name;
+  s->dsc.setPartitions(partitions);
+  if (!bench && coalesceMs) s->dsc.setCoalesce(coalesceMs, 10);
+  setNonBlock(fd);
+
+  if (!bench) {
+    std::string out;
+    addSiteHead(out, *s);
+    out += ",\"name\":";
+    addJson(out, name.c_str());
+    out += ",\"event\":\"open\"}\n";
+    flushOut(out);
+  }
+
+  worker_t &w = *workers[s->id % workers.size()];
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  ev.data.ptr = s;
+  liveSites++;
+  epoll_ctl(w.epfd, EPOLL_CTL_ADD, fd, &ev);
+  return s;
+}
+
+// Opens a pseudo-terminal, returns the master and sets the slave's fd and name
+static int openPty(int &slave, std::string &name)
+{
+  int master = posix_openpt(O_RDWR | O_NOCTTY);
+  if (master < 0 || grantpt(master) < 0 || unlockpt(master) < 0) {
+    if (master >= 0) close(master);
+    return -1;
+  }
+  name = ptsname(master);
+  slave = open(name.c_str(), O_RDWR | O_NOCTTY);
+  if (slave < 0) {
+    close(master);
+    return -1;
+  }
+  setRaw(slave);
+  return master;
+}
+
+static int listenUnix(const char *path)
+{
+  struct sockaddr_un addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sun_family = AF_UNIX;
+  strncpy(addr.sun_path, path, sizeof(addr.sun_path) - 1);
+  unlink(path);
+  int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+  if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 128) < 0) {
+    perror(path);
+    exit(1);
+  }
+  return fd;
+}
+
+static int listenTcp(int port)
+{
+  struct sockaddr_in addr;
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_ANY);
+  addr.sin_port = htons(port);
+  int on = 1;
+  int fd = socket(AF_INET, SOCK_STREAM, 0);
+  if (fd >= 0) setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &on, sizeof(on));
+  if (fd < 0 || bind(fd, (struct sockaddr*)&addr, sizeof(addr)) < 0 || listen(fd, 128) < 0) {
+    perror("tcp");
+    exit(1);
+  }
+  return fd;
+}
+
+// Accepts a connection on listener "fd" as a new site
+static void acceptSite(int fd, bool tcp)
+{
+  struct sockaddr_in addr;
+  socklen_t len = sizeof(addr);
+  int conn = accept(fd, tcp ? (struct sockaddr*)&addr : NULL, tcp ? &len : NULL);
+  if (conn < 0) return;
+  char name[64];
+  if (tcp) snprintf(name, sizeof(name), "tcp:%s:%u", inet_ntoa(addr.sin_addr), ntohs(addr.sin_port));
+  else snprintf(name, sizeof(name), "unix:%d", conn);
+  siteAdd(conn, name);
+}
+
+static void startWorkers(int count)
+{
+  for (int i=0;i<count;i++) {
+    worker_t *w = new worker_t;
+    w->epfd = epoll_create1(0);
+    workers.push_back(w);
+  }
+  for (size_t i=0;i<workers.size();i++) workers[i]->thread = std::thread(workerLoop, workers[i]);
+}
+
+static void stopWorkers(void)
+{
+  stopping = true;
+  for (size_t i=0;i<workers.size();i++) workers[i]->thread.join();
+}
+
+static void printStats(unsigned long ms)
+{
+  unsigned long words = 0;
+  std::string out = "{\"stats\":{";
+  char buf[64];
+  snprintf(buf, sizeof(buf), "\"sites\":%d", (int)liveSites);
+  out += buf;
+  out += ",\"per_core\":[";
+  for (size_t i=0;i<workers.size();i++) {
+    worker_t &w = *workers[i];
+    unsigned long wWords = w.words - w.lastWords, cpuUs = w.cpuUs - w.lastCpuUs;
+    w.lastWords += wWords;
+    w.lastCpuUs += cpuUs;
+    words += wWords;
+    if (i) out += ',';
+    snprintf(buf, sizeof(buf), "%lu", cpuUs ? (unsigned long)(wWords * 1000000.0 / cpuUs) : 0UL);
+    out += buf;
+  }
+  out += ']';
+  addNum(out, "words", words);
+  addNum(out, "words_per_sec", ms ? words * 1000UL / ms : 0);
+  addNum(out, "bad_lines", badLines.exchange(0));
+  out += "}}\n";
+  flushOut(out);
+}
+
+static void onSignal(int)
+{
+  stopping = true;
+}
+
+// --------------------------------------------------------------------------------------------------------
+// ----------------------------------------------  BENCHMARK  ---------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+static void writeAll(int fd, const char *buf, size_t len)
+{
+  while (len) {
+    ssize_t n = write(fd, buf, len);
+    if (n < 0) {
+      if (errno == EINTR) continue;
+      return;
+    }
+    buf += n;
+    len -= n;
+  }
+}
+
+// Plays "cycles" rounds of the corpus into each of the feeder's streams
+static void benchFeed(std::vector<int> fds, long cycles)
+{
+  std::string round;
+  for (int i=0;i<CORPUS_LEN;i++) {
+    round += corpus[i];
+    round += '\n';
+  }
+  for (long c=0;c<cycles;c++) {
+    for (size_t i=0;i<fds.size();i++) writeAll(fds[i], round.data(), round.size());
+  }
+  for (size_t i=0;i<fds.size();i++) close(fds[i]);
+}
+
+static int runBench(int streams, long cycles, bool pty, int workerCount)
+{
+  bench = true;
+
+  // The output of one round decoded on its own, the streams must match it
+  dscBus_t refState;
+  DSC ref(refState);
+  ref.setPartitions(partitions);
+  benchHash = 2166136261u;
+  for (int i=0;i<CORPUS_LEN;i++) {
+    if (decodeLine(ref, corpus[i]) > 0) benchHash = hashWord(benchHash, ref);
+  }
+
+  startWorkers(workerCount);
+  std::vector<std::vector<int> > feeds(workers.size());
+  for (int i=0;i<streams;i++) {
+    int fds[2];
+    std::string name;
+    if (pty) {
+      fds[0] = openPty(fds[1], name);
+      if (fds[0] < 0) {
+        perror("pty");
+        return 1;
+      }
+    }
+    else if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) < 0) {
+      perror("socketpair");
+      return 1;
+    }
+    site_t *s = siteAdd(fds[0], name);
+    feeds[s->id % workers.size()].push_back(fds[1]);   // Fed beside its worker
+  }
+
+  unsigned long start = micros();
+  std::vector<std::thread> feeders;
+  for (size_t i=0;i<feeds.size();i++) feeders.push_back(std::thread(benchFeed, feeds[i], cycles));
+  for (size_t i=0;i<feeders.size();i++) feeders[i].join();
+  while (liveSites > 0) usleep(1000);
+  unsigned long us = micros() - start;
+  stopWorkers();
+
+  unsigned long words = 0, cpuUs = 0;
+  std::string perCore;
+  for (size_t i=0;i<workers.size();i++) {
+    worker_t &w = *workers[i];
+    words += w.words;
+    cpuUs += w.cpuUs;
+    char buf[24];
+    snprintf(buf, sizeof(buf), "%s%lu", i ? "," : "",
+             w.cpuUs ? (unsigned long)(w.words * 1000000.0 / w.cpuUs) : 0UL);
+    perCore += buf;
+  }
+  unsigned long expected = (unsigned long)streams * cycles * CORPUS_LEN;
+  bool pass = (words == expected && benchBad == 0);
+
+  printf("{\"bench\":{\"transport\":\"%s\",\"streams\":%d,\"workers\":%u,\"words\":%lu,"
+         "\"expected\":%lu,\"mismatches\":%lu,\"seconds\":%.3f,\"words_per_sec\":%lu,"
+         "\"words_per_core_sec\":%lu,\"per_core\":[%s],\"result\":\"%s\"}}\n",
+         pty ? "pty" : "unix", streams, (unsigned)workers.size(), words, expected,
+         (unsigned long)benchBad, us / 1e6, us ? (unsigned long)(words * 1000000.0 / us) : 0UL,
+         cpuUs ? (unsigned long)(words * 1000000.0 / cpuUs) : 0UL, perCore.c_str(),
+         pass ? "PASS" : "FAIL");
+  return pass ? 0 : 1;
+}
+
+// --------------------------------------------------------------------------------------------------------
+// -------------------------------------------------  MAIN  -----------------------------------------------
+// --------------------------------------------------------------------------------------------------------
+
+static void usage(void)
+{
+  fprintf(stderr,
+    "usage: dsc_gateway [-w workers] [-u socket] [-p port] [-t ptys] [-n partitions]\n"
+    "                   [-c window_ms] [device ...]\n"
+    "       dsc_gateway -b streams [-k cycles] [-w workers] [-t 1]\n");
+  exit(2);
+}
+
+int main(int argc, char **argv)
+{
+  int workerCount = std::thread::hardware_concurrency();
+  const char *unixPath = NULL;
+  int tcpPort = 0, ptys = 0, benchStreams = 0;
+  long cycles = 1000;
+
+  int opt;
+  while ((opt = getopt(argc, argv, "w:u:p:t:n:c:b:k:")) != -1) {
+    switch (opt) {
+      case 'w': workerCount = atoi(optarg); break;
+      case 'u': unixPath = optarg; break;
+      case 'p': tcpPort = atoi(optarg); break;
+      case 't': ptys = atoi(optarg); break;
+      case 'n': partitions = atoi(optarg); break;
+      case 'c': coalesceMs = atoi(optarg); break;
+      case 'b': benchStreams = atoi(optarg); break;
+      case 'k': cycles = atol(optarg); break;
+      default: usage();
+    }
+  }
+  if (workerCount < 1) workerCount = 1;
+  if (partitions < 1 || partitions > MAX_PARTITIONS) usage();
+  signal(SIGPIPE, SIG_IGN);
+
+  if (benchStreams > 0) return runBench(benchStreams, cycles, ptys > 0, workerCount);
+  if (!unixPath && !tcpPort && !ptys && optind >= argc) usage();
+
+  signal(SIGINT, onSignal);
+  signal(SIGTERM, onSignal);
+  startWorkers(workerCount);
+
+  // ---------------- Streams opened at the start ----------------
+  for (int i=0;i<ptys;i++) {
+    int slave;
+    std::string name;
+    int master = openPty(slave, name);
+    if (master < 0) {
+      perror("pty");
+      return 1;
+    }
+    siteAdd(master, "pty:" + name, slave);   // The slave stays open between writers
+  }
+  for (int i=optind;i<argc;i++) {
+    int fd = open(argv[i], O_RDONLY | O_NOCTTY);
+    if (fd < 0) {
+      perror(argv[i]);
+      continue;
+    }
+    setRaw(fd);
+    siteAdd(fd, std::string("dev:") + argv[i]);
+  }
+
+  // ---------------- Listeners, each connection is a site ----------------
+  int epfd = epoll_create1(0);
+  int unixFd = unixPath ? listenUnix(unixPath) : -1;
+  int tcpFd = tcpPort ? listenTcp(tcpPort) : -1;
+  struct epoll_event ev;
+  ev.events = EPOLLIN;
+  if (unixFd >= 0) { ev.data.fd = unixFd; epoll_ctl(epfd, EPOLL_CTL_ADD, unixFd, &ev); }
+  if (tcpFd >= 0) { ev.data.fd = tcpFd; epoll_ctl(epfd, EPOLL_CTL_ADD, tcpFd, &ev); }
+
+  unsigned long lastStats = millis();
+  while (!stopping) {
+    struct epoll_event ready[2];
+    int n = epoll_wait(epfd, ready, 2, 500);
+    for (int i=0;i<n;i++) acceptSite(ready[i].data.fd, ready[i].data.fd == tcpFd);
+    if (millis() - lastStats >= STATS_MS) {
+      printStats(millis() - lastStats);
+      lastStats = millis();
+    }
+  }
+
+  stopWorkers();
+  if (unixPath) unlink(unixPath);
+  return 0;
+}
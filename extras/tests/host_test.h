@@ -0,0 +1,77 @@
+// DSC_18XX Arduino Interface - Host Test Helpers
+//
+// - The checks and keybus helpers shared by the host tests (see run_tests.sh), which
+//   are built with the host Arduino.h of extras/gateway and its test clock.  A failed
+//   CHECK() prints the line and carries on, testDone() then fails the test.
+//
+// - clockWord() sends a word to a DSC instance the way the keybus clocks it, through
+//   injectEdge(), so the ISR half of the library (capture, hand-off, priority lane)
+//   runs as on a board.
+//
+//
+
+#ifndef DSC_HOST_TEST_H
+#define DSC_HOST_TEST_H
+
+#include <Arduino.h>
+#include <DSC.h>
+#include <stdio.h>
+#include <string.h>
+
+static int testFails = 0;
+
+#define CHECK(c) \
+  do { if (!(c)) { printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #c); testFails++; } } while (0)
+
+#define CHECK_STR(a, b) \
+  do { const char *a_ = (a), *b_ = (b); \
+       if (!a_ || !b_ || strcmp(a_, b_) != 0) { \
+         printf("%s:%d: \"%s\" != \"%s\"\n", __FILE__, __LINE__, a_ ? a_ : "(null)", b_ ? b_ : "(null)"); \
+         testFails++; } } while (0)
+
+// Prints the result, and returns the test's exit code
+static int testDone(const char *name)
+{
+  printf("%s: %s\n", name, testFails ? "FAIL" : "PASS");
+  return testFails ? 1 : 0;
+}
+
+// Runs process() until the word loaded is done, and returns its result
+static int processWord(DSC &dsc)
+{
+  int result;
+  do result = dsc.process(); while (result == -3);
+  return result;
+}
+
+// ----- Keybus Timing (micros, as DSC_Sim) -----
+const unsigned long TEST_BIT_US = 1000;     // Clock period of one bit
+const unsigned long TEST_GAP_US = 15000;    // New word marker
+
+/* Clocks a word into "dsc" with injectEdge(), from time "us" (moved on past it).  The
+ * panel word "p" is "pBits" long and the keypad word "k" is "kBits" long (all 1's
+ * after it), laid out as the ISR builds them.  The keypad bits are sent on the falling
+ * edges and the panel bits on the rising edges, after the new word gap, whose first
+ * edge hands off the word before.  The word itself is handed off by the next word, or
+ * clockEnd().
+ */
+static void clockWord(DSC &dsc, unsigned long &us, const byte *p, byte pBits,
+                      const byte *k, byte kBits)
+{
+  for (byte n=0;n<pBits;n++) {
+    bool kBit = (n < kBits) ? DSC::wordBit(k, kBits, n, 0) : 1;
+    us += n ? TEST_BIT_US / 2 : TEST_GAP_US;
+    dsc.injectEdge(0, kBit, us);
+    us += TEST_BIT_US / 2;
+    dsc.injectEdge(1, DSC::wordBit(p, pBits, n, 1), us);
+  }
+}
+
+// The first edge after the gap, which hands off the last word clocked in
+static void clockEnd(DSC &dsc, unsigned long &us)
+{
+  us += TEST_GAP_US;
+  dsc.injectEdge(0, 1, us);
+}
+
+#endif
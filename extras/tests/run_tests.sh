@@ -0,0 +1,34 @@
+#!/bin/sh
+# DSC_18XX Arduino Interface - Host Tests
+#
+# Builds each test_xxx.cpp here with the library and the host Arduino.h (see
+# extras/gateway), and runs it.  From the library folder:
+#   sh extras/tests/run_tests.sh [test_xxx ...]
+# A test's own build flags are on its "// FLAGS:" line.  Exits with 1 if a test
+# fails to build or fails.
+
+CXX=${CXX:-g++}
+OUT=${OUT:-/tmp/dsc_tests}
+mkdir -p "$OUT" || exit 1
+
+tests=$*
+[ -n "$tests" ] || tests=$(cd extras/tests && ls test_*.cpp | sed 's/\.cpp$//')
+
+fails=0
+for t in $tests; do
+  src=extras/tests/$t.cpp
+  flags=$(sed -n 's|^// FLAGS: *||p' "$src")
+  if ! $CXX -std=gnu++11 -O2 -pthread -DDSC_HOST_TEST_CLOCK -I extras/gateway -I . $flags \
+       "$src" DSC.cpp DSC_Sim.cpp DSC_Trace.cpp DSC_Vol.cpp -o "$OUT/$t"; then
+    echo "$t: BUILD FAILED"
+    fails=$((fails + 1))
+    continue
+  fi
+  "$OUT/$t" || { echo "$t: FAIL (exit $?)"; fails=$((fails + 1)); }
+done
+
+if [ $fails -ne 0 ]; then
+  echo "$fails test(s) failed"
+  exit 1
+fi
+echo "All tests passed"
@@ -0,0 +1,167 @@
+// DSC_18XX Arduino Interface - Host Test, Heap Allocations
+//
+// - The library's buffers are all static or in the instance, so decoding must never
+//   use the heap.  malloc() and its family, and operator new and delete, are
+//   replaced here with versions which count the calls.  After one warm up pass,
+//   the corpus of the Benchmark example is replayed many times, with replayWord()
+//   and clocked in through injectEdge(), with a subscriber, the formatters, a key
+//   sent and a trace running, and no call may be counted.
+//
+//
+
+#include "host_test.h"
+#include <DSC_Trace.h>
+#include <new>
+
+extern "C" void *__libc_malloc(size_t size);
+extern "C" void *__libc_calloc(size_t n, size_t size);
+extern "C" void *__libc_realloc(void *p, size_t size);
+extern "C" void __libc_free(void *p);
+
+// ----- Counted heap -----
+static unsigned long allocs, frees;
+
+extern "C" void *malloc(size_t size)
+{
+  allocs++;
+  return __libc_malloc(size);
+}
+
+extern "C" void *calloc(size_t n, size_t size)
+{
+  allocs++;
+  return __libc_calloc(n, size);
+}
+
+extern "C" void *realloc(void *p, size_t size)
+{
+  allocs++;
+  return __libc_realloc(p, size);
+}
+
+extern "C" void free(void *p)
+{
+  if (p) frees++;
+  __libc_free(p);
+}
+
+void *operator new(size_t size) { allocs++; return __libc_malloc(size ? size : 1); }
+void *operator new[](size_t size) { allocs++; return __libc_malloc(size ? size : 1); }
+void operator delete(void *p) noexcept { if (p) frees++; __libc_free(p); }
+void operator delete[](void *p) noexcept { if (p) frees++; __libc_free(p); }
+void operator delete(void *p, size_t) noexcept { if (p) frees++; __libc_free(p); }
+void operator delete[](void *p, size_t) noexcept { if (p) frees++; __libc_free(p); }
+
+typedef struct
+{
+  byte p[PNL_ARR_SIZE];
+  byte pLen;
+  byte k[KPD_ARR_SIZE];
+}
+testWord_t;
+
+// The Benchmark example's corpus
+const testWord_t corpus[] = {
+  { { 0x05, 0x00, 0x81, 0x01, 0x90, 0xc7 }, 41, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0x05, 0x00, 0x82, 0x08, 0x90, 0xc7 }, 41, { 0xff, 0x82, 0xff, 0xff, 0xff } },
+  { { 0x05, 0x00, 0xd4, 0x26, 0x10, 0xc7 }, 41, { 0xff, 0xd7, 0xff, 0xff, 0xff } },
+  { { 0x05, 0x00, 0x82, 0x0c, 0x90, 0xc7 }, 41, { 0xff, 0xf0, 0xff, 0xff, 0xff } },
+  { { 0x27, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x2c }, 57, { 0xbb, 0xff, 0xff, 0xff, 0xff } },
+  { { 0x2d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x81, 0xae }, 57, { 0xff, 0x44, 0xff, 0xff, 0xff } },
+  { { 0x34, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x34 }, 57, { 0xdd, 0xff, 0xff, 0xff, 0xff } },
+  { { 0x3e, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x3d }, 57, { 0xee, 0xff, 0xff, 0xff, 0xff } },
+  { { 0x3e, 0x00, 0x00, 0x00, 0x00, 0x00, 0xc2, 0x00 }, 57, { 0xff, 0xab, 0xff, 0xff, 0xff } },
+  { { 0xa5, 0x00, 0x16, 0x2a, 0x4b, 0x20, 0x9d, 0xed }, 57, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0xa5, 0x00, 0x16, 0x2a, 0x4b, 0x20, 0xc4, 0x14 }, 57, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0xa5, 0x00, 0x16, 0x2a, 0x4b, 0x20, 0xe2, 0x32 }, 57, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0xa5, 0x00, 0x16, 0x2a, 0x4b, 0x10, 0xc0, 0x00 }, 57, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0x11, 0x00, 0xaa, 0xaa, 0x00 }, 33, { 0xff, 0xff, 0xff, 0xfe, 0x7f } },
+  { { 0x0a, 0x00, 0x80, 0x01, 0x00, 0x00, 0x8b }, 49, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0x5d, 0x00, 0x00, 0x00, 0x04, 0x00, 0x61 }, 49, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0x63, 0x00, 0x00, 0x63 }, 25, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0xb1, 0x00, 0xff, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0xb0 }, 89,
+    { 0xff, 0xff, 0xff, 0xff, 0xff } } };
+
+const byte CORPUS_LEN = sizeof(corpus) / sizeof(corpus[0]);
+const unsigned int PASSES = 200;
+
+// Output of the trace, thrown away
+class NullPrint : public Print
+{
+  public:
+    virtual size_t write(uint8_t c) { return 1; }
+    using Print::write;
+};
+
+unsigned long events, chars;
+
+// The formatters return NULL if the word wasn't decoded
+static size_t textLen(const char *s)
+{
+  return s ? strlen(s) : 0;
+}
+
+void onWord(const dscEvent_t &event)
+{
+  events++;
+  chars += textLen(event.msg);
+}
+
+// One pass over the corpus, both ways in, returns the words decoded
+static unsigned int replay(DSC &dsc, DSC_Trace &trace, unsigned long &us)
+{
+  unsigned int words = 0;
+  for (byte i=0;i<CORPUS_LEN;i++) {
+    const testWord_t &w = corpus[i];
+    dsc.replayWord(w.p, w.pLen, w.k, 40);
+    if (processWord(dsc) > 0) words++;
+    chars += textLen(dsc.get_pnlFormat());
+    chars += textLen(dsc.get_kpdFormat());
+    chars += textLen(dsc.get_pnlArray());
+    chars += textLen(dsc.get_kpdArray());
+    chars += textLen(dsc.get_pnlRaw());
+    chars += textLen(dsc.get_kpdRaw());
+  }
+  dsc.send_key(KEY_1);
+  for (byte i=0;i<CORPUS_LEN;i++) {
+    const testWord_t &w = corpus[i];
+    clockWord(dsc, us, w.p, w.pLen, w.k, 40);
+    int result;
+    while ((result = dsc.process()) != -1) if (result > 0) words++;
+    trace.update();
+  }
+  return words;
+}
+
+int main()
+{
+  static traceEdge_t edges[256];
+  static NullPrint sink;
+  DSC dsc(0);
+  DSC_Trace trace(dsc, edges, 256);
+  dsc.subscribe(onWord, DSC_PANEL, NULL);
+  dsc.subscribe(onWord, DSC_KEYPAD, NULL);
+  trace.begin(sink);
+
+  unsigned long us = 0;
+  replay(dsc, trace, us);                     // Warm up
+
+  unsigned long allocsBefore = allocs, freesBefore = frees;
+  unsigned long words = 0;
+  for (unsigned int n=0;n<PASSES;n++) words += replay(dsc, trace, us);
+  unsigned long newAllocs = allocs - allocsBefore, newFrees = frees - freesBefore;
+
+  CHECK(words >= (unsigned long)PASSES * CORPUS_LEN);
+  CHECK(events > 0 && chars > 0);
+  CHECK(newAllocs == 0);
+  CHECK(newFrees == 0);
+
+  // The counters do count, one of each here (kept, it may not be optimized away)
+  char * volatile p = new char[16];
+  delete[] p;
+  CHECK(allocs - allocsBefore == newAllocs + 1);
+  CHECK(frees - freesBefore == newFrees + 1);
+  printf("%lu words, %lu allocations, %lu frees\n", words, newAllocs, newFrees);
+
+  return testDone("test_alloc");
+}
@@ -0,0 +1,121 @@
+// DSC_18XX Arduino Interface - Host Test, Batch Decode
+//
+// - decodeBatch() on a block of generated panel words must give the same checksum,
+//   command class, zones and partition 1 lights as decoding each word on its own
+//   with process().  The words are of every length the buffer holds, half with a
+//   valid checksum, and the block doesn't end on a whole chunk (BATCH_CHUNK), so the
+//   last chunk is a short one.  Nothing is written past the end of the block.
+//   decodeBatch() doesn't repair words, so resync is off for process() too.
+//
+// - The time per word of decodeBatch() is printed, build with and without
+//   -fno-tree-vectorize to compare the vectorized loops with plain ones:
+//     CXX="g++ -march=x86-64-v3" sh extras/tests/run_tests.sh test_batch
+//
+//
+// FLAGS: -O3
+
+#include "host_test.h"
+#include <chrono>
+
+const unsigned int WORDS = 16 * 64 + 7;
+const unsigned int ROUNDS = 2000;
+
+const byte cmds[] = { 0x05, 0x27, 0x2d, 0x34, 0x3e, 0xa5, 0x11, 0x0a, 0x4c, 0x00 };
+
+byte rows[PNL_ARR_SIZE][WORDS], lens[WORDS];
+byte valid[WORDS + 1], cls[WORDS + 1], lights[WORDS + 1];
+unsigned long zones[WORDS + 1];
+
+pnlData_t scalar;   // Panel fields of the word decoded on its own
+bool decoded;
+
+static unsigned long seed = 1;
+static byte nextByte(void)
+{
+  seed = seed * 1103515245UL + 12345UL;
+  return (seed >> 16) & 0xff;
+}
+
+void onPanel(const dscEvent_t &event)
+{
+  scalar = *event.pnl;
+  decoded = true;
+}
+
+int main()
+{
+  // ---------------- The block ----------------
+  for (unsigned int w=0;w<WORDS;w++) {
+    byte p[PNL_ARR_SIZE];
+    byte len = 9 + 8 * (1 + nextByte() % (PNL_ARR_SIZE - 2));    // 17 bits to a full buffer
+    for (byte i=0;i<PNL_ARR_SIZE;i++) p[i] = nextByte();
+    p[0] = cmds[nextByte() % sizeof(cmds)];
+    p[1] = 0;
+    if (w & 1) {
+      byte last = 1 + (len - 9) / 8, sum = p[0];
+      for (byte i=2;i<last;i++) sum += p[i];
+      p[last] = sum;
+    }
+    for (byte i=0;i<PNL_ARR_SIZE;i++) rows[i][w] = p[i];
+    lens[w] = len;
+  }
+  valid[WORDS] = 0xee, cls[WORDS] = 0xee, lights[WORDS] = 0xee, zones[WORDS] = 0xeeee;
+
+  dscBatch_t batch;
+  batch.count = WORDS;
+  batch.len = lens;
+  for (byte i=0;i<PNL_ARR_SIZE;i++) batch.bytes[i] = rows[i];
+  batch.valid = valid, batch.cls = cls, batch.zones = zones, batch.lights = lights;
+  DSC::decodeBatch(batch);
+
+  CHECK(valid[WORDS] == 0xee && cls[WORDS] == 0xee);
+  CHECK(lights[WORDS] == 0xee && zones[WORDS] == 0xeeee);
+
+  // ---------------- Each word on its own ----------------
+  dscBus_t state;
+  DSC dsc(state);
+  dsc.subscribe(onPanel, DSC_PANEL, NULL);
+  dsc.setResync(false);
+  const byte idle[KPD_ARR_SIZE] = { 0xff, 0xff, 0xff, 0xff, 0xff };
+  unsigned int mismatches = 0, compared = 0, valids = 0;
+  for (unsigned int w=0;w<WORDS;w++) {
+    byte p[PNL_ARR_SIZE];
+    for (byte i=0;i<PNL_ARR_SIZE;i++) p[i] = rows[i][w];
+    dsc.replayWord(p, lens[w], idle, 0);
+    bool ok = (valid[w] == dsc.pnlChkValid());
+    valids += valid[w];
+    decoded = false;
+    while (dsc.process() == -3);
+
+    byte cmd = p[0];
+    byte k = CMD_OTHER;
+    if (cmd == 0x05) k = CMD_STATUS;
+    if (cmd == 0x27 || cmd == 0x2d || cmd == 0x34 || cmd == 0x3e) k = CMD_ZONES;
+    if (cmd == 0xa5) k = CMD_INFO;
+    if (cmd == 0x11) k = CMD_QUERY;
+    ok = ok && cls[w] == k;
+    ok = ok && (k == CMD_ZONES || zones[w] == 0) && (k == CMD_STATUS || lights[w] == 0);
+
+    // Words which were decoded (not a duplicate, or an unknown command)
+    if (decoded) {
+      byte shift = (cmd == 0x2d) ? 8 : (cmd == 0x34) ? 16 : (cmd == 0x3e) ? 24 : 0;
+      if (k == CMD_ZONES)  ok = ok && zones[w] == ((unsigned long)scalar.zones << shift);
+      if (k == CMD_STATUS) ok = ok && lights[w] == scalar.lights[0];
+      compared++;
+    }
+    if (!ok) {
+      if (mismatches++ < 10) printf("word %u (0x%02x, %u bits) differs\n", w, cmd, lens[w]);
+    }
+  }
+  CHECK(mismatches == 0);
+  CHECK(valids >= WORDS / 2);
+  CHECK(compared >= WORDS / 2);
+
+  // ---------------- Timing ----------------
+  std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+  for (unsigned int r=0;r<ROUNDS;r++) DSC::decodeBatch(batch);
+  double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count();
+  printf("decodeBatch: %.2f ns/word\n", ns / ((double)ROUNDS * WORDS));
+
+  return testDone("test_batch");
+}
@@ -0,0 +1,83 @@
+// DSC_18XX Arduino Interface - Host Test, Process Budget
+//
+// - A word decoded by process(budget_us) over several calls, one stage each, must
+//   give the same result as process() in one call: the message, the time of an 0xa5
+//   word, and get_time(), which is set in the state stage and must still be set when
+//   the format stage ends the word in a later call.
+//
+// - The test clock moves micros() on 1 us per call, so a budget of 1 us runs one
+//   stage per process() call.
+//
+//
+
+#include "host_test.h"
+
+// Info word, armed by user 5, and a status word
+const byte info[PNL_ARR_SIZE] = { 0xa5, 0x00, 0x16, 0x2a, 0x4b, 0x20, 0x9d, 0xed };
+const byte status[PNL_ARR_SIZE] = { 0x05, 0x00, 0x81, 0x01, 0x90, 0xc7 };
+const byte idle[KPD_ARR_SIZE] = { 0xff, 0xff, 0xff, 0xff, 0xff };
+
+// Runs process(1) until the word is done, returns its result and counts the calls
+static int processSplit(DSC &dsc, int &calls)
+{
+  int result;
+  calls = 0;
+  do {
+    result = dsc.process(1);
+    calls++;
+  } while (result == -3);
+  return result;
+}
+
+static void checkSameTime(DSC &a, DSC &b)
+{
+  CHECK(a.yy == b.yy);
+  CHECK(a.mm == b.mm);
+  CHECK(a.dd == b.dd);
+  CHECK(a.HH == b.HH);
+  CHECK(a.MM == b.MM);
+}
+
+int main()
+{
+  // ---------------- The word in one call ----------------
+  dscBus_t refState;
+  DSC ref(refState);
+  ref.replayWord(info, 57, idle, 0);
+  CHECK(ref.process(0) == 1);
+  CHECK(ref.get_time());
+  CHECK(ref.get_pCmd() == 0xa5);
+
+  // ---------------- The same word split over calls ----------------
+  dscBus_t state;
+  DSC dsc(state);
+  int calls;
+  dsc.replayWord(info, 57, idle, 0);
+  CHECK(processSplit(dsc, calls) == 1);
+  CHECK(calls >= 4);                          // One stage per call
+  CHECK(dsc.get_time());
+  CHECK(dsc.get_pCmd() == 0xa5);
+  CHECK_STR(dsc.get_pMsg(), ref.get_pMsg());
+  checkSameTime(dsc, ref);
+
+  // Still set while no word is waiting, until the next word is taken
+  CHECK(dsc.process(1) == -1);
+  CHECK(dsc.get_time());
+  dsc.replayWord(status, 41, idle, 0);
+  CHECK(processSplit(dsc, calls) == 1);
+  CHECK(!dsc.get_time());
+
+  // ---------------- Through the ISR and the capture queue ----------------
+  dscBus_t busState;
+  DSC bus(busState);
+  unsigned long us = 0;
+  clockWord(bus, us, info, 57, idle, 40);
+  clockEnd(bus, us);
+  CHECK(processSplit(bus, calls) == 1);
+  CHECK(calls >= 4);
+  CHECK(bus.get_time());
+  CHECK_STR(bus.get_pMsg(), ref.get_pMsg());
+  checkSameTime(bus, ref);
+
+  return testDone("test_budget");
+}
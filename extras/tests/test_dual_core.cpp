@@ -0,0 +1,120 @@
+// DSC_18XX Arduino Interface - Host Test, Dual Core
+//
+// - beginDualCore() on two threads, built with ThreadSanitizer and DSC_SMP: the
+//   capture thread clocks the words in with injectEdge(), as the ISR on the capture
+//   core, and wakes the decode thread through the ready hook, as wordReadyNotify().
+//   The decode thread runs decodeLoop(): it waits for the notification (or the
+//   timeout) and runs process() until the pipeline is empty.  It also sends keys,
+//   which the capture thread clocks out.
+//
+// - The fire light goes on and off, so the priority flags and their time are raised
+//   by the ISR while process() takes them.  Any data race between the two halves of
+//   the library fails the test (ThreadSanitizer's exit code), and every word must be
+//   decoded, and the fire light must reach the priority callback.
+//
+//
+// FLAGS: -fsanitize=thread -DDSC_SMP=1 -g -O1
+
+#include "host_test.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+const unsigned int WORDS = 300;
+
+const byte ready[PNL_ARR_SIZE]  = { 0x05, 0x00, 0x81, 0x01, 0x90, 0xc7 };
+const byte fireOn[PNL_ARR_SIZE] = { 0x05, 0x00, 0xc1, 0x01, 0x90, 0xc7 };
+const byte idle[KPD_ARR_SIZE]   = { 0xff, 0xff, 0xff, 0xff, 0xff };
+
+// ----- The task notification of the decode task -----
+std::mutex lock;
+std::condition_variable notify;
+unsigned int notified;
+
+void wordReadyNotify(void)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  notified++;
+  notify.notify_one();
+}
+
+// Waits for a notification and takes them all, false at the timeout
+static bool notifyTake(unsigned int ms)
+{
+  std::unique_lock<std::mutex> guard(lock);
+  bool given = notify.wait_for(guard, std::chrono::milliseconds(ms), [] { return notified > 0; });
+  notified = 0;
+  return given;
+}
+
+unsigned int prioCalls;
+unsigned long prioLatency;
+
+// A slow callback, so the ISR is words ahead and raises the next flag while process()
+// is still between taking the flags and freeing the word's queue slot
+void onPriority(byte flags, unsigned long latency)
+{
+  if (flags & PRIO_FIRE) prioCalls++;
+  prioLatency = latency;
+  std::this_thread::sleep_for(std::chrono::microseconds(200));
+}
+
+// Runs the words through the two halves of the library on two threads, the decode
+// thread polling process() as loop() does, or woken by the ready hook as the decode
+// task of beginDualCore().  The threads only share the count of words taken, with
+// relaxed loads and stores, so nothing outside the library orders their accesses.
+static void run(bool notified)
+{
+  DSC dsc(0);                                 // On a keybus, to send keys
+  if (notified) dsc.setWordReadyHook(wordReadyNotify);
+  dsc.setPriorityCallback(onPriority);
+  prioCalls = 0, prioLatency = 0;
+
+  std::atomic<unsigned int> taken(0);
+  std::atomic<bool> captureDone(false);
+  unsigned int decoded = 0, keys = 0;
+  unsigned long passes = 0;
+
+  // ---------------- loop(), or decodeLoop() ----------------
+  std::thread decode([&]() {
+    for (;;) {
+      bool given = notified ? notifyTake(100) : true;
+      bool done = captureDone.load(std::memory_order_relaxed);
+      int result;
+      while ((result = dsc.process()) != -1) {
+        if (result >= 0) taken.store(taken.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        if (result > 0) decoded++;
+      }
+      if (dsc.send_key(KEY_1)) keys++;            // Once the last one has been sent
+      // All decoded, or nothing came before the timeout (or in a long while, polling)
+      if (done && (decoded == WORDS || !given || ++passes > 1000000UL)) break;
+    }
+  });
+
+  // ---------------- The ISR ----------------
+  unsigned long us = 0;
+  for (unsigned int i=0;i<WORDS;i++) {
+    // The first edge of word i hands off word i-1, keep the queue from overflowing
+    while (i - taken.load(std::memory_order_relaxed) > PIPE_DEPTH - 1) std::this_thread::yield();
+    clockWord(dsc, us, (i & 1) ? fireOn : ready, 41, idle, 40);
+  }
+  clockEnd(dsc, us);
+  captureDone.store(true, std::memory_order_relaxed);
+  decode.join();
+
+  CHECK(decoded == WORDS);
+  CHECK(prioCalls > 0 && prioCalls <= WORDS / 2); // Flags raised together are taken once
+  CHECK(prioLatency > 0);
+  CHECK(keys > 1);
+  CHECK(dsc.get_dropped() == 0);
+  CHECK(!dsc.wordReady());
+}
+
+int main()
+{
+  run(false);
+  run(true);
+  return testDone("test_dual_core");
+}
@@ -0,0 +1,124 @@
+// DSC_18XX Arduino Interface - Host Test, Keypad Keys
+//
+// - Each key sent with send_key(key) is clocked out on the keypad data line, and the
+//   word seen on the line must decode back to the same key, with the text the
+//   button chain gave before the key table (kpdKeys) replaced it.
+//
+// - Every pair of 1st and 2nd keypad bytes is decoded and must give the same text as
+//   that chain and formatKeypad(): a button, the keypad response, an unknown code
+//   after kOut, or no text.
+//
+//
+
+#include "host_test.h"
+
+const byte ready[PNL_ARR_SIZE] = { 0x05, 0x00, 0x81, 0x01, 0x90, 0xc7 };
+const byte idle[KPD_ARR_SIZE] = { 0xff, 0xff, 0xff, 0xff, 0xff };
+
+// The button names as the decoder gave them before the key table
+static const char *preTableButton(byte cmd, byte code)
+{
+  const char *btn = NULL;
+  if (cmd == kOut) {
+    if (code == one)          btn = "1";
+    else if (code == two)     btn = "2";
+    else if (code == three)   btn = "3";
+    else if (code == four)    btn = "4";
+    else if (code == five)    btn = "5";
+    else if (code == six)     btn = "6";
+    else if (code == seven)   btn = "7";
+    else if (code == eight)   btn = "8";
+    else if (code == nine)    btn = "9";
+    else if (code == aster)   btn = "*";
+    else if (code == zero)    btn = "0";
+    else if (code == pound)   btn = "#";
+    else if (code == stay)    btn = "Stay";
+    else if (code == away)    btn = "Away";
+    else if (code == chime)   btn = "Chime";
+    else if (code == reset)   btn = "Reset";
+    else if (code == kExit)   btn = "Exit";
+    else if (code == lArrow)  btn = "<";
+    else if (code == rArrow)  btn = ">";
+  }
+  if (cmd == fire)  btn = "Fire";
+  if (cmd == aux)   btn = "Aux";
+  if (cmd == panic) btn = "Panic";
+  return btn;
+}
+
+// The keypad message formatKeypad() gave before the key table
+static void preTableText(byte cmd, byte code, char *text)
+{
+  const char *btn = preTableButton(cmd, code);
+  text[0] = 0;
+  if (btn) sprintf(text, "[Button] %s", btn);
+  else if (cmd == kOut && code == kOut) strcpy(text, "[Keypad Response]");
+  else if (cmd == kOut) sprintf(text, "[Keypad] 0x%x (Unknown)", code);
+}
+
+kpdData_t kpd;
+unsigned int kpdEvents;
+
+void onKeypad(const dscEvent_t &event)
+{
+  kpd = *event.kpd;
+  kpdEvents++;
+}
+
+int main()
+{
+  dscBus_t state;
+  DSC decoder(state);
+  decoder.subscribe(onKeypad, DSC_KEYPAD, NULL);
+  char expect[32];
+
+  // ---------------- Each key, sent and decoded back ----------------
+  for (byte key=1;key<KEY_COUNT;key++) {
+    DSC sender(0);
+    CHECK(sender.send_key(key));
+
+    // The keypad data line as the panel sees it on each falling edge of the word
+    byte line[KPD_ARR_SIZE] = { 0 };
+    unsigned long us = 0;
+    for (byte n=0;n<41;n++) {
+      us += n ? TEST_BIT_US / 2 : TEST_GAP_US;
+      bool level = sender.injectEdge(0, 1, us);
+      if (n < 40) line[n / 8] |= level << (7 - n % 8);
+      us += TEST_BIT_US / 2;
+      sender.injectEdge(1, DSC::wordBit(ready, 41, n, 1), us);
+    }
+
+    CHECK(line[2] == kOut && line[3] == kOut);
+
+    // The word on the line, decoded by another instance
+    kpdEvents = 0;
+    decoder.replayWord(ready, 41, idle, 40);      // Not a duplicate of the last key
+    processWord(decoder);
+    decoder.replayWord(ready, 41, line, 40);
+    processWord(decoder);
+    CHECK(kpdEvents == 1);
+    CHECK(kpd.key == key);
+    preTableText(line[0], line[1], expect);
+    CHECK(expect[0] != 0);
+    CHECK_STR(decoder.get_kMsg(), expect);
+  }
+
+  // ---------------- Every 1st and 2nd byte ----------------
+  unsigned int buttons = 0, mismatches = 0;
+  for (int cmd=0;cmd<256;cmd++) {
+    for (int code=0;code<256;code++) {
+      byte k[KPD_ARR_SIZE] = { (byte)cmd, (byte)code, 0x7f, 0xff, 0xff };
+      decoder.replayWord(ready, 0, k, 24);
+      processWord(decoder);
+      const char *got = decoder.get_kCmd() ? decoder.get_kMsg() : "";
+      preTableText(cmd, code, expect);
+      if (preTableButton(cmd, code)) buttons++;
+      if (strcmp(got, expect) != 0 && mismatches++ < 10)
+        printf("0x%02x 0x%02x: \"%s\" != \"%s\"\n", cmd, code, got, expect);
+    }
+  }
+  CHECK(mismatches == 0);
+  CHECK(buttons == 19 + 3 * 256);
+
+  return testDone("test_keys");
+}
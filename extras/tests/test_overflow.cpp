@@ -0,0 +1,51 @@
+// DSC_18XX Arduino Interface - Host Test, Word Buffer Overflow
+//
+// - A panel word longer than its buffer (PNL_ARR_SIZE) is counted as an overflow and
+//   dropped at the hand-off, it must not be decoded from the bytes which were kept.
+//   The words either side of it are decoded as usual.
+//
+//
+
+#include "host_test.h"
+
+const byte LONG_BITS = 9 + (PNL_ARR_SIZE - 2) * 8 + 16;    // Two bytes too long
+
+// Status words, ready and armed
+const byte ready[PNL_ARR_SIZE] = { 0x05, 0x00, 0x81, 0x01, 0x90, 0xc7 };
+const byte armed[PNL_ARR_SIZE] = { 0x05, 0x00, 0x82, 0x08, 0x90, 0xc7 };
+const byte key1[KPD_ARR_SIZE] = { 0xff, 0x82, 0xff, 0xff, 0xff };
+const byte idle[KPD_ARR_SIZE] = { 0xff, 0xff, 0xff, 0xff, 0xff };
+
+int main()
+{
+  // The armed status word with two more bytes, and key 1 pressed beside it
+  byte longWord[PNL_ARR_SIZE + 2] = { 0 };
+  memcpy(longWord, armed, 6);
+
+  dscBus_t state;
+  DSC dsc(state);
+  unsigned long us = 0;
+
+  clockWord(dsc, us, ready, 41, idle, 40);
+  clockWord(dsc, us, longWord, LONG_BITS, key1, 40);
+  CHECK(processWord(dsc) == 1);               // Ready
+  CHECK_STR(dsc.get_pMsg(), "[Status] Ready");
+
+  // The long word is handed off by the next one, and dropped
+  clockWord(dsc, us, ready, 41, idle, 40);
+  CHECK(dsc.get_overflows(DSC_PANEL) == 1);
+  CHECK(dsc.process() == -1);                 // Nothing queued
+  CHECK(dsc.getLights() == LIGHT_READY);
+
+  // The words after it are decoded
+  clockWord(dsc, us, armed, 41, key1, 40);
+  clockEnd(dsc, us);
+  CHECK(processWord(dsc) == 0);               // Ready again, a duplicate
+  CHECK(processWord(dsc) == 3);
+  CHECK_STR(dsc.get_pMsg(), "[Status] Armed, Exit Delay");
+  CHECK_STR(dsc.get_kMsg(), "[Button] 1");
+  CHECK(dsc.get_overflows(DSC_PANEL) == 1);
+  CHECK(dsc.get_dropped() == 0);
+
+  return testDone("test_overflow");
+}
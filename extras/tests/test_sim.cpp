@@ -0,0 +1,100 @@
+// DSC_18XX Arduino Interface - Host Test, Simulator Scenario
+//
+// - A DSC_Sim scenario, not repeating, is run with step() until it ends, as the
+//   Simulator example runs it.  Every scripted event must be decoded exactly once:
+//   zone 3 opening and closing, arming and disarming by user 5, key 1 and the fire
+//   light.  The Fire button is sent twice, as a keypad sends it, and decoded twice.
+//   A key sent with send_key() part way through must be seen by the virtual panel.
+//
+// - Once ended, step() stays false and nothing more is clocked in.
+//
+//
+
+#include "host_test.h"
+#include <DSC_Sim.h>
+
+const simStep_t scenario[] = {
+  { 10000, SIM_ZONE_OPEN,  3    },
+  { 20000, SIM_ZONE_CLOSE, 3    },
+  { 30000, SIM_ARM,        5    },
+  { 40000, SIM_KEY,        one  },
+  { 45000, SIM_KEY,        fire },
+  { 50000, SIM_DISARM,     5    },
+  { 55000, SIM_FIRE,       1    },
+  { 60000, SIM_END,        0    } };
+
+const unsigned long SEND_MS = 42000;  // When the key is sent
+
+byte zoneOpens, zoneCloses, arms, disarms, keys, fires;
+bool zone3;
+
+void onPanel(const dscEvent_t &event)
+{
+  if (event.cmd == 0x27) {
+    bool open = event.pnl->zones & (1 << 2);
+    if (open && !zone3) zoneOpens++;
+    if (!open && zone3) zoneCloses++;
+    zone3 = open;
+  }
+  else if (event.cmd == 0xa5 && event.pnl->user == 5) {
+    if (event.pnl->arm == 0x02) arms++;
+    if (event.pnl->arm == 0x03) disarms++;
+  }
+}
+
+void onButton(const dscEvent_t &event)
+{
+  if (event.kpd->key == KEY_1) keys++;
+  if (event.kpd->key == KEY_FIRE) fires++;
+}
+
+int main()
+{
+  DSC dsc;
+  DSC_Sim sim(dsc);
+  dsc.subscribe(onPanel, DSC_PANEL, NULL);
+  dsc.subscribe(onButton, DSC_KEYPAD, NULL);
+
+  sim.begin(scenario, false);
+  bool keySent = false;
+  unsigned long words = 0;
+  while (sim.step()) {
+    words++;
+    while (dsc.process() != -1);
+    if (!keySent && sim.getTime() >= SEND_MS) keySent = dsc.send_key(KEY_2);
+    CHECK(words < 1000000UL);                 // Runs away if the scenario never ends
+    if (words >= 1000000UL) break;
+  }
+  while (dsc.process() != -1);
+
+  // ---------------- Every event once ----------------
+  CHECK(zoneOpens == 1);
+  CHECK(zoneCloses == 1);
+  CHECK(arms == 1);
+  CHECK(disarms == 1);
+  CHECK(keys == 1);
+  CHECK(fires == 2);                          // Sent twice, as a keypad does
+  CHECK(sim.getPasses() == 0);
+  CHECK(sim.getTime() >= 60000UL);
+
+  // The key sent, as the panel saw it
+  byte sent[KSD_ARR_SIZE];
+  CHECK(keySent);
+  CHECK(sim.getSent(sent) == 1);
+  CHECK(sent[0] == kOut && sent[1] == two);
+
+  // The state left by the scenario: disarmed, zones closed, fire light
+  CHECK(dsc.getLights() == (LIGHT_READY | LIGHT_FIRE));
+  CHECK(dsc.getUser() == 5);
+  CHECK(dsc.get_dropped() == 0);
+  CHECK(dsc.get_overflows(DSC_PANEL) == 0);
+
+  // ---------------- Ended ----------------
+  unsigned long ended = sim.getTime();
+  CHECK(!sim.step());
+  CHECK(!sim.update());
+  CHECK(sim.getTime() == ended);
+  CHECK(dsc.process() == -1);
+
+  return testDone("test_sim");
+}
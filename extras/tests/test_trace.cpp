@@ -0,0 +1,62 @@
+// DSC_18XX Arduino Interface - Host Test, Trace Buffer
+//
+// - A DSC_Trace with a buffer of 0 edges (or no buffer) writes the header and traces
+//   nothing: no edge is taken from the instance and update() writes none.  A buffer
+//   of 3 edges is rounded down to 2 and traces the words clocked in.
+//
+//
+
+#include "host_test.h"
+#include <DSC_Trace.h>
+
+const byte ready[PNL_ARR_SIZE] = { 0x05, 0x00, 0x81, 0x01, 0x90, 0xc7 };
+const byte idle[KPD_ARR_SIZE] = { 0xff, 0xff, 0xff, 0xff, 0xff };
+
+// Counts the characters written
+class CountPrint : public Print
+{
+  public:
+    unsigned long chars;
+    CountPrint() : chars(0) {}
+    virtual size_t write(uint8_t c) { chars++; return 1; }
+    using Print::write;
+};
+
+// Clocks a word in and writes the trace out, returns the edges written
+static unsigned int traceWord(DSC &dsc, DSC_Trace &trace, unsigned long &us)
+{
+  clockWord(dsc, us, ready, 41, idle, 40);
+  unsigned int edges = trace.update();
+  while (dsc.process() != -1) edges += trace.update();
+  return edges;
+}
+
+int main()
+{
+  static traceEdge_t edges[4];
+  unsigned long us = 0;
+
+  // ---------------- A buffer of 0 edges, and no buffer ----------------
+  for (byte n=0;n<2;n++) {
+    DSC dsc(0);
+    DSC_Trace trace(dsc, n ? NULL : edges, n ? 4 : 0);
+    CountPrint out;
+    trace.begin(out);
+    CHECK(out.chars > 0);                     // The header
+    unsigned long header = out.chars;
+    CHECK(traceWord(dsc, trace, us) == 0);
+    CHECK(out.chars == header);
+    CHECK(trace.update() == 0);
+  }
+
+  // ---------------- A buffer of 3 edges ----------------
+  DSC dsc(0);
+  DSC_Trace trace(dsc, edges, 3);
+  CountPrint out;
+  trace.begin(out);
+  unsigned long header = out.chars;
+  CHECK(traceWord(dsc, trace, us) > 0);
+  CHECK(out.chars > header);
+
+  return testDone("test_trace");
+}
@@ -0,0 +1,142 @@
+// DSC_18XX Arduino Interface - Host Test, Two Keybuses
+//
+// - Two instances on keybus 0 and 1 are clocked edge by edge in turn through
+//   injectEdge(), as their interrupts would run, each with its own words.  Each must
+//   decode exactly what it decodes when clocked on its own, with no word, light, or
+//   priority flag of the other keybus.
+//
+// - A third instance asking for keybus 1 is refused it.
+//
+//
+
+#include "host_test.h"
+#include <string>
+#include <vector>
+
+typedef struct
+{
+  byte p[PNL_ARR_SIZE];
+  byte pBits;
+  byte k[KPD_ARR_SIZE];
+}
+testWord_t;
+
+// Keybus 0: ready, zones 1 and 3, fire light with key 1, armed
+const testWord_t wordsA[] = {
+  { { 0x05, 0x00, 0x81, 0x01, 0x90, 0xc7 }, 41, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0x27, 0x00, 0x00, 0x00, 0x00, 0x00, 0x05, 0x2c }, 57, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0x05, 0x00, 0xc1, 0x01, 0x90, 0xc7 }, 41, { 0xff, 0x82, 0xff, 0xff, 0xff } },
+  { { 0x05, 0x00, 0x82, 0x08, 0x90, 0xc7 }, 41, { 0xff, 0xff, 0xff, 0xff, 0xff } } };
+
+// Keybus 1: zones 9 and 16, not ready with trouble and key Stay, armed by user 5,
+// zones 25-32, the Panic button
+const testWord_t wordsB[] = {
+  { { 0x2d, 0x00, 0x00, 0x00, 0x00, 0x00, 0x81, 0xae }, 57, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0x05, 0x00, 0x10, 0x26, 0x10, 0xc7 }, 41, { 0xff, 0xd7, 0xff, 0xff, 0xff } },
+  { { 0xa5, 0x00, 0x16, 0x2a, 0x4b, 0x20, 0x9d, 0xed }, 57, { 0xff, 0xff, 0xff, 0xff, 0xff } },
+  { { 0x3e, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x3d }, 57, { 0xee, 0xff, 0xff, 0xff, 0xff } } };
+
+const byte WORDS = 4;
+
+// One keybus being clocked, edge by edge as clockWord() sends them
+struct feed_t
+{
+  DSC *dsc;
+  const testWord_t *words;
+  byte word;                        // Word being sent, WORDS once they all have been
+  int edge;                         // Next edge of the word
+  unsigned long us;
+
+  // Sends the next edge, false once every word has been handed off
+  bool next(void)
+    {
+      if (word == WORDS) return false;
+      const testWord_t &w = words[word];
+      int n = edge / 2;
+      if (edge % 2 == 0) {
+        bool kBit = (n < 40) ? DSC::wordBit(w.k, 40, n, 0) : 1;   // All 1's after
+        us += n ? TEST_BIT_US / 2 : TEST_GAP_US;
+        dsc->injectEdge(0, kBit, us);
+      }
+      else {
+        us += TEST_BIT_US / 2;
+        dsc->injectEdge(1, DSC::wordBit(w.p, w.pBits, n, 1), us);
+      }
+      if (++edge == 2 * w.pBits) {
+        edge = 0;
+        if (++word == WORDS) clockEnd(*dsc, us);
+      }
+      return true;
+    }
+};
+
+// Processes every word waiting, and adds what was decoded to "out"
+static void drain(DSC &dsc, std::vector<std::string> &out)
+{
+  int result;
+  while ((result = dsc.process()) != -1) {
+    if (result <= 0) continue;
+    if (dsc.get_pCmd()) out.push_back(dsc.get_pMsg());
+    if (dsc.get_kCmd()) out.push_back(dsc.get_kMsg());
+  }
+}
+
+// What an instance decodes from the words clocked in on its own
+static std::vector<std::string> alone(const testWord_t *words, byte &lights, byte &prio)
+{
+  dscBus_t state;
+  DSC dsc(state);
+  feed_t f = { &dsc, words, 0, 0, 0 };
+  std::vector<std::string> out;
+  while (f.next()) drain(dsc, out);
+  drain(dsc, out);
+  lights = dsc.getLights();
+  prio = dsc.getPriority();
+  return out;
+}
+
+int main()
+{
+  byte lightsA, lightsB, prioA, prioB;
+  std::vector<std::string> soloA = alone(wordsA, lightsA, prioA);
+  std::vector<std::string> soloB = alone(wordsB, lightsB, prioB);
+  CHECK(soloA.size() >= WORDS);
+  CHECK(soloB.size() >= WORDS);
+
+  // ---------------- Both keybuses, edges interleaved ----------------
+  DSC a(0), b(1);
+  CHECK(a.valid() && b.valid());
+  DSC taken(1);
+  CHECK(!taken.valid());                      // Keybus 1 is b's
+  CHECK(!taken.begin());
+
+  feed_t fa = { &a, wordsA, 0, 0, 0 };
+  feed_t fb = { &b, wordsB, 0, 0, 300 };      // Edges offset from keybus 0
+  std::vector<std::string> outA, outB;
+  bool moreA = true, moreB = true;
+  while (moreA || moreB) {
+    if (moreA) moreA = fa.next();
+    if (moreB) moreB = fb.next();
+    drain(a, outA);
+    drain(b, outB);
+  }
+
+  CHECK(outA == soloA);
+  CHECK(outB == soloB);
+  for (size_t i=0;i<outA.size() && i<soloA.size();i++) CHECK_STR(outA[i].c_str(), soloA[i].c_str());
+  for (size_t i=0;i<outB.size() && i<soloB.size();i++) CHECK_STR(outB[i].c_str(), soloB[i].c_str());
+
+  // Each keybus's state and priority flags are its own
+  CHECK(a.getLights() == lightsA);
+  CHECK(b.getLights() == lightsB);
+  CHECK(lightsA != lightsB);
+  CHECK(a.getPriority() == prioA);
+  CHECK(b.getPriority() == prioB);
+  CHECK(prioA == PRIO_FIRE);
+  CHECK(prioB == PRIO_KEY_PANIC);
+  CHECK(a.getUser() == 0);
+  CHECK(b.getUser() == 5);
+  CHECK(a.get_dropped() == 0 && b.get_dropped() == 0);
+
+  return testDone("test_two_buses");
+}
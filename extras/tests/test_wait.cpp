@@ -0,0 +1,134 @@
+// DSC_18XX Arduino Interface - Host Test, Word Ready Hook and waitWord()
+//
+// - The ISR and process() on two threads, as a board's interrupt and loop(), with a
+//   condition variable standing in for the sleep: the ready hook (setWordReadyHook())
+//   sets a flag and wakes the decode thread, which sleeps until then, and runs
+//   process() while wordReady().  Every word clocked in must be decoded, and the
+//   decode thread must never find a word waiting after sleeping the whole timeout
+//   (a lost wake up).  The priority flags wake it too.
+//
+// - waitWord() returns at once with a word waiting, returns false at the timeout
+//   with none (a thread moves the clock on, as the millis() timer), and returns
+//   once a word is handed off from the other thread.
+//
+//
+// FLAGS: -DDSC_SMP=1
+
+#include "host_test.h"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+
+const unsigned int WORDS = 400;
+
+const byte ready[PNL_ARR_SIZE] = { 0x05, 0x00, 0x81, 0x01, 0x90, 0xc7 };
+const byte armed[PNL_ARR_SIZE] = { 0x05, 0x00, 0x82, 0x08, 0x90, 0xc7 };
+const byte fireOn[PNL_ARR_SIZE] = { 0x05, 0x00, 0xc1, 0x01, 0x90, 0xc7 };
+const byte idle[KPD_ARR_SIZE] = { 0xff, 0xff, 0xff, 0xff, 0xff };
+
+// ----- The sleep stand-in -----
+std::mutex lock;
+std::condition_variable wake;
+bool woken;
+unsigned int hookCalls;
+
+void onReady(void)
+{
+  std::lock_guard<std::mutex> guard(lock);
+  woken = true;
+  hookCalls++;
+  wake.notify_one();
+}
+
+std::atomic<unsigned int> prioCalls(0);
+
+void onPriority(byte flags, unsigned long latency)
+{
+  if (flags & PRIO_FIRE) prioCalls++;
+}
+
+static const byte *wordAt(unsigned int i)
+{
+  if (i % 50 == 49) return fireOn;
+  return (i & 1) ? armed : ready;
+}
+
+int main()
+{
+  dscBus_t state;
+  DSC dsc(state);
+  dsc.setWordReadyHook(onReady);
+  dsc.setPriorityCallback(onPriority);
+
+  // ---------------- The decode thread, woken by the hook ----------------
+  std::atomic<unsigned int> taken(0);
+  std::atomic<bool> captureDone(false);
+  unsigned int decoded = 0, lostWakes = 0, wakes = 0;
+
+  std::thread decode([&]() {
+    for (;;) {
+      bool timedOut;
+      {
+        std::unique_lock<std::mutex> guard(lock);
+        timedOut = !wake.wait_for(guard, std::chrono::milliseconds(100), [] { return woken; });
+        woken = false;
+      }
+      if (timedOut && dsc.wordReady()) lostWakes++;
+      if (!timedOut) wakes++;
+      int result;
+      while ((result = dsc.process()) != -1) {
+        if (result >= 0) taken++;
+        if (result > 0) decoded++;
+      }
+      if (timedOut && captureDone) break;
+    }
+  });
+
+  // ---------------- The capture thread (this one), as the ISR ----------------
+  unsigned long us = 0;
+  for (unsigned int i=0;i<WORDS;i++) {
+    // The first edge of word i hands off word i-1, keep the queue from overflowing
+    while (i - taken > PIPE_DEPTH - 1) std::this_thread::yield();
+    clockWord(dsc, us, wordAt(i), 41, idle, 40);
+  }
+  clockEnd(dsc, us);
+  captureDone = true;
+  decode.join();
+
+  CHECK(decoded == WORDS);
+  CHECK(lostWakes == 0);
+  CHECK(wakes > 0);
+  CHECK(hookCalls >= WORDS);
+  CHECK(prioCalls == WORDS / 50);
+  CHECK(dsc.get_dropped() == 0);
+  CHECK(!dsc.wordReady());
+
+  // ---------------- waitWord() ----------------
+  dsc.setWordReadyHook(NULL);
+  dsc.replayWord(ready, 41, idle, 0);
+  CHECK(dsc.waitWord(0));                     // At once, a word is waiting
+  while (dsc.process() != -1);
+
+  // None waiting, the clock is moved on by another thread until the timeout
+  std::atomic<bool> stop(false);
+  hostClockStep() = 100;
+  std::thread timer([&]() { while (!stop) { micros(); std::this_thread::yield(); } });
+  CHECK(!dsc.waitWord(5));
+
+  // Woken by a word handed off from another thread
+  std::thread capture([&]() {
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    clockWord(dsc, us, armed, 41, idle, 40);
+    clockEnd(dsc, us);
+  });
+  CHECK(dsc.waitWord(0));
+  capture.join();
+  stop = true;
+  timer.join();
+  CHECK(processWord(dsc) == 1);
+  CHECK_STR(dsc.get_pMsg(), "[Status] Armed, Exit Delay");
+
+  return testDone("test_wait");
+}